@@ -0,0 +1,122 @@
+"""
+ST7701 Animation Example
+Overlays and Scene sprites moved by the driver instead of by Python.
+
+A toast slides in and fades out, a cursor bounces back and forth and a
+badge pulses, all stepped by the scan-out at the start of every frame.
+Then a Scene's sprites and scroll are animated, with the loop only
+calling render(). How long each loop iteration took is printed, to show
+how little Python is left doing.
+"""
+
+import st7701
+import framebuf
+import time
+from array import array
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+TILE = 32
+TRANSPARENT = 0xF81F    # magenta
+
+
+def make_box(w, h, colour, label):
+    buf = bytearray(w * h * 2)
+    fb = framebuf.FrameBuffer(buf, w, h, framebuf.RGB565)
+    fb.fill(colour)
+    fb.rect(0, 0, w, h, st7701.WHITE)
+    fb.text(label, 10, h // 2 - 4, st7701.WHITE)
+    return buf
+
+
+def make_ball(size, colour):
+    buf = bytearray(size * size * 2)
+    fb = framebuf.FrameBuffer(buf, size, size, framebuf.RGB565)
+    fb.fill(TRANSPARENT)
+    r = size // 2 - 1
+    fb.ellipse(size // 2, size // 2, r, r, colour, True)
+    return buf
+
+
+def overlays(display, width, height):
+    print("Overlays...")
+    display.overlay(0, make_box(200, 48, st7701.rgb565(0, 90, 160), "Saved"), 200, 48)
+    display.overlay_move(0, width, 20)
+    display.animate(0, st7701.ANIM_POS, (width - 220, 20), 500, st7701.EASE_OUT_BACK)
+    display.animate(0, st7701.ANIM_OPACITY, 0, 400, delay_ms=2000)
+
+    display.overlay(1, make_ball(24, st7701.WHITE), 24, 24, st7701.OVERLAY_RGB565, TRANSPARENT)
+    display.overlay_move(1, 20, height - 60)
+    display.animate(1, st7701.ANIM_POS, (width - 44, height - 60), 1200, repeat=4, yoyo=True)
+
+    display.overlay(2, make_box(80, 32, st7701.RED, "LIVE"), 80, 32)
+    display.overlay_move(2, 20, 20)
+    display.animate(2, st7701.ANIM_OPACITY, 64, 600, st7701.EASE_IN_OUT, repeat=-1, yoyo=True)
+
+    # Python has nothing to do while they run
+    worst = 0
+    while display.animating(0) or display.animating(1):
+        start = time.ticks_us()
+        time.sleep_ms(16)
+        worst = max(worst, time.ticks_diff(time.ticks_us(), start) - 16000)
+    print(f"  done, {display.animating()} still running (the badge repeats forever), "
+          f"worst loop overrun {worst} us")
+
+    display.stop_animation(2)
+    for i in range(3):
+        display.overlay(i, None)
+
+
+def scene(display, width, height):
+    print("Scene...")
+    sheet = bytearray(TILE * 2 * TILE * 2)
+    fb = framebuf.FrameBuffer(sheet, TILE * 2, TILE, framebuf.RGB565)
+    fb.fill_rect(0, 0, TILE, TILE, st7701.rgb565(40, 140, 40))
+    fb.fill_rect(TILE, 0, TILE, TILE, st7701.rgb565(40, 80, 200))
+    tiles = array('H', ((x + y) % 2 for y in range(32) for x in range(32)))
+    scene = st7701.Scene(display, sheet, TILE * 2, TILE, TILE, tiles, 32, 32)
+
+    for i, colour in enumerate((st7701.RED, st7701.rgb565(255, 200, 0), st7701.rgb565(255, 0, 255))):
+        scene.sprite(i, make_ball(48, colour), 48, 48, TRANSPARENT)
+        scene.move(i, 20 + i * 100, 40)
+        scene.animate(i, st7701.ANIM_POS, (20 + i * 100, height - 88), 900 + i * 300,
+                      st7701.EASE_IN_OUT, delay_ms=i * 200, repeat=3, yoyo=True)
+    scene.animate(None, st7701.ANIM_SCROLL, (TILE * 16, 0), 5000, st7701.EASE_LINEAR)
+
+    frames = 0
+    busy = 0
+    while scene.animating():
+        start = time.ticks_us()
+        scene.render()
+        busy += time.ticks_diff(time.ticks_us(), start)
+        frames += 1
+        time.sleep_ms(16)
+    print(f"  {frames} renders, {busy // frames} us each on average")
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS)
+    display.init()
+    width, height = display.width(), display.height()
+
+    fb = framebuf.FrameBuffer(display.framebuffer(), width, height, framebuf.RGB565)
+    fb.fill(st7701.rgb565(20, 20, 40))
+
+    overlays(display, width, height)
+    scene(display, width, height)
+
+    display.deinit()
+
+
+main()
@@ -0,0 +1,87 @@
+"""
+ST7701 Asset Cache Example
+Switches between two screens that share an image and a font, and compares
+loading them from the filesystem every time (as load_image() in disp_raw.py
+does) with keeping them decoded in an AssetCache.
+
+Needs bliss.raw (in this folder) and a font from font2bin.py:
+    python utils/font2bin.py DejaVuSans.ttf 24 sans24.bin
+"""
+
+import st7701
+import time
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+IMAGE_FILE = "bliss.raw"
+FONT_FILE = "sans24.bin"
+SWITCHES = 10
+
+
+def screen(canvas, image, font, n):
+    """The 854x480 picture turned to fill the portrait screen, and a caption"""
+    canvas.blit_rotated(image, 0, 0, 90 if n & 1 else 270)
+    canvas.text(font, f"Screen {n}", 20, 20, st7701.WHITE)
+
+
+def uncached(canvas):
+    start = time.ticks_ms()
+    for n in range(SWITCHES):
+        with open(IMAGE_FILE, "rb") as f:
+            data = bytearray(f.read())
+        w = data[0] | (data[1] << 8)
+        h = data[2] | (data[3] << 8)
+        pixels = memoryview(data)[4:]
+        w, h = st7701.rotate(pixels, w, h, 90 if n & 1 else 270)
+        font = st7701.Font(FONT_FILE)
+        canvas.blit(pixels, 0, 0, w, h)
+        canvas.text(font, f"Screen {n}", 20, 20, st7701.WHITE)
+    return time.ticks_diff(time.ticks_ms(), start) / SWITCHES
+
+
+def cached(canvas, cache):
+    start = time.ticks_ms()
+    for n in range(SWITCHES):
+        screen(canvas, cache.get(IMAGE_FILE), cache.get(FONT_FILE), n)
+    return time.ticks_diff(time.ticks_ms(), start) / SWITCHES
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS)
+    display.init()
+    canvas = st7701.Canvas(display)
+
+    cache = st7701.AssetCache(2 * 1024 * 1024)
+
+    print(f"Reading files every switch  {uncached(canvas):>6.1f} ms/screen")
+    print(f"From the asset cache        {cached(canvas, cache):>6.1f} ms/screen")
+    hits, misses, evictions, used, count = cache.stats()
+    print(f"  {hits} hits, {misses} misses, {evictions} evictions, {count} assets in {used // 1024} KB")
+
+    # A half-size thumbnail is a variant made from the cached original
+    thumb = cache.get(IMAGE_FILE, rotation=270, scale=0.5)
+    thumb.pin()         # e.g. on every screen - never evicted
+    canvas.blit(thumb, 480 - thumb.width(), 854 - thumb.height())
+
+    # A smaller budget evicts the least recently used assets that aren't pinned
+    cache.budget(thumb.width() * thumb.height() * 2 + 64 * 1024)
+    print("After shrinking the budget:", cache.stats())
+    thumb.unpin()
+
+    time.sleep(5)
+    cache.close()
+    display.deinit()
+
+
+main()
@@ -0,0 +1,82 @@
+"""
+ST7701 asyncio Frame Sync Example
+A double-buffered bouncing box drawn by one task while another keeps
+counting in the background.
+
+await display.flip(wait=False) gives the event loop back until the next
+frame starts, so the counter task keeps running between frames, where a
+plain flip() would block it.
+"""
+
+import st7701
+import asyncio
+import time
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+FRAMES = 300
+SIZE = 60
+
+ticks = 0
+
+
+async def counter():
+    """Stands in for I/O - runs whenever the render task is waiting"""
+    global ticks
+    while True:
+        ticks += 1
+        await asyncio.sleep_ms(0)
+
+
+async def render(display, canvas):
+    x, y, dx, dy = 0, 0, 5, 7
+    w, h = display.width(), display.height()
+    budget_left = 0
+    start = time.ticks_ms()
+    first = await display.vsync()
+
+    for i in range(FRAMES):
+        canvas.fill(st7701.BLACK)
+        canvas.fill_rect(x, y, SIZE, SIZE, st7701.rgb565(0, 160, 255))
+        canvas.fill_rect(0, 0, ticks % w, 8, st7701.WHITE)    # the counter, as a bar
+
+        x += dx
+        y += dy
+        if not 0 <= x <= w - SIZE:
+            dx = -dx
+        if not 0 <= y <= h - SIZE:
+            dy = -dy
+
+        budget_left += display.frame_budget_us()
+        await display.flip(wait=False)
+
+    frames = await display.vsync() - first
+    ms = time.ticks_diff(time.ticks_ms(), start)
+    print(f"{FRAMES} flips in {frames} panel frames, {FRAMES * 1000 / ms:.1f} fps")
+    print(f"{budget_left // FRAMES} us of each frame left after drawing, {ticks} counter ticks")
+
+
+async def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS,
+                            buffers=2)
+    display.init()
+    canvas = st7701.Canvas(display)
+
+    background = asyncio.create_task(counter())
+    await render(display, canvas)
+    background.cancel()
+    display.deinit()
+
+
+asyncio.run(main())
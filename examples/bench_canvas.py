@@ -0,0 +1,72 @@
+"""
+ST7701 Canvas Benchmark
+Compares per-call cost of Canvas primitives with framebuf, and shows a
+widget drawn in its own coordinates with translate() and push_clip().
+"""
+
+import st7701
+import framebuf
+import time
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+CALLS = 2000
+
+
+def bench(name, fn):
+    start = time.ticks_us()
+    for i in range(CALLS):
+        fn(i & 255, i & 511)
+    elapsed = time.ticks_diff(time.ticks_us(), start)
+    print(f"  {name:<28} {elapsed * 1000 // CALLS:>6} ns/call")
+
+
+def button(canvas, x, y, w, h, label_colour):
+    """A widget drawn in local coordinates - the clip keeps it inside its box"""
+    canvas.push_clip(x, y, w, h)
+    canvas.translate(x, y)
+    canvas.fill(st7701.rgb565(40, 40, 60))
+    canvas.hline(0, 0, w, st7701.WHITE)
+    canvas.hline(0, h - 1, w, st7701.WHITE)
+    canvas.vline(0, 0, h, st7701.WHITE)
+    canvas.vline(w - 1, 0, h, st7701.WHITE)
+    canvas.fill_rect(w // 2 - 100, h // 2 - 8, 200, 16, label_colour)     # wider than the button
+    canvas.pop_clip()
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS)
+    display.init()
+    width, height = display.width(), display.height()
+
+    canvas = st7701.Canvas(display)
+    fb = framebuf.FrameBuffer(display.framebuffer(), width, height, framebuf.RGB565)
+    view = canvas.view()
+
+    print("Per-call cost (8x8 rectangles, pixels)...")
+    bench("framebuf.fill_rect", lambda x, y: fb.fill_rect(x, y, 8, 8, 0xF800))
+    bench("Canvas.fill_rect", lambda x, y: canvas.fill_rect(x, y, 8, 8, 0x07E0))
+    bench("framebuf.pixel", lambda x, y: fb.pixel(x, y, 0xFFFF))
+    bench("Canvas.pixel", lambda x, y: canvas.pixel(x, y, 0xFFFF))
+    bench("view[] (no clipping)", lambda x, y: view.__setitem__(y * width + x, 0x001F))
+
+    canvas.fill(st7701.BLACK)
+    for i in range(6):
+        button(canvas, 40, 60 + i * 120, 400, 80, st7701.rgb565(255, 40 * i, 0))
+
+    time.sleep(5)
+    display.deinit()
+
+
+main()
@@ -0,0 +1,79 @@
+"""
+ST7701 Refresh Rate Benchmark
+Measures the PSRAM bandwidth left for the application at different pixel
+clocks, then shows auto_refresh() dropping the rate when nothing is drawn.
+
+The scan-out reads the whole framebuffer from PSRAM on every refresh (about
+50 MB/s at 30 MHz), so lowering the pixel clock while the picture is static
+speeds up everything else that uses PSRAM.
+"""
+
+import st7701
+import time
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+FRAME_CLOCKS = 550 * 886        # pixel clocks per frame, porches included
+COPY_SIZE = 256 * 1024          # larger than the cache, so every copy hits PSRAM
+COPIES = 40
+
+
+def psram_copy_rate(src, dst):
+    """Copy between two buffers on the (PSRAM) heap, returns MB/s"""
+    start = time.ticks_us()
+    for _ in range(COPIES):
+        dst[:] = src
+    elapsed = time.ticks_diff(time.ticks_us(), start)
+    return COPY_SIZE * COPIES / elapsed      # bytes per us = MB/s
+
+
+def measure(display, pclk, src, dst):
+    display.refresh(pclk)
+    time.sleep_ms(100)                      # let the new clock take effect
+    rate = psram_copy_rate(src, dst)
+    print(f"  {pclk / 1e6:>5.1f} MHz ({pclk / FRAME_CLOCKS:>5.1f} Hz)   {rate:>6.1f} MB/s copy")
+    return rate
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS)
+    display.init()
+
+    canvas = st7701.Canvas(display)
+    canvas.fill(st7701.rgb565(0, 60, 120))
+
+    src = bytearray(COPY_SIZE)
+    dst = bytearray(COPY_SIZE)
+
+    print("PSRAM copy rate against the pixel clock...")
+    full = measure(display, 30_000_000, src, dst)
+    for pclk in (20_000_000, 12_000_000, 8_000_000, 4_000_000):
+        rate = measure(display, pclk, src, dst)
+    print(f"  gained {rate - full:.1f} MB/s ({(rate / full - 1) * 100:.0f}%) at the lowest rate")
+    display.refresh(30_000_000)
+
+    # Drop to 8 MHz after half a second without drawing
+    display.auto_refresh(30, 8_000_000)
+    print("Auto refresh:")
+    for i in range(5):
+        canvas.fill_rect(0, 0, 480, 100, st7701.rgb565(40 * i, 0, 0))    # any draw wakes it up
+        print(f"  after a draw    {display.refresh() / 1e6:>5.1f} MHz")
+        time.sleep_ms(1000)
+        print(f"  after 1s idle   {display.refresh() / 1e6:>5.1f} MHz")
+
+    display.auto_refresh(0)
+    display.deinit()
+
+
+main()
@@ -0,0 +1,68 @@
+"""
+ST7701 Text Benchmark
+Measures native text rendering throughput in glyphs per second.
+
+Create a font on a PC first and copy it to the board:
+    python utils/font2bin.py DejaVuSans.ttf 24 sans24.bin
+"""
+
+import st7701
+import time
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+FONT_FILE = "sans24.bin"
+LINE = "The quick brown fox 0123456789"
+LINES = 200
+
+
+def bench(display, font, name, bg, clip=None):
+    line_h = font.line_height()
+    rows = display.height() // line_h
+
+    start = time.ticks_us()
+    for i in range(LINES):
+        display.draw_text(font, LINE, 0, (i % rows) * line_h, st7701.WHITE, bg, clip)
+    elapsed = time.ticks_diff(time.ticks_us(), start)
+
+    glyphs = LINES * len(LINE)
+    print(f"  {name:<24} {glyphs * 1000000 // elapsed:>8} glyphs/s  ({elapsed // LINES} us/line)")
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS)
+    display.init()
+
+    font = st7701.Font(FONT_FILE)
+    print(f"Font line height: {font.line_height()}, '{LINE}' is {font.measure(LINE)}")
+
+    # Warm the glyph cache so the first run isn't penalised
+    display.draw_text(font, LINE, 0, 0, st7701.WHITE, st7701.BLACK)
+
+    print("Text benchmark...")
+    bench(display, font, "opaque background", st7701.BLACK)
+    bench(display, font, "blended", -1)
+    bench(display, font, "clipped to half width", st7701.BLACK, (0, 0, display.width() // 2, display.height()))
+
+    start = time.ticks_us()
+    for _ in range(LINES):
+        font.measure(LINE)
+    elapsed = time.ticks_diff(time.ticks_us(), start)
+    print(f"  {'measure only':<24} {LINES * len(LINE) * 1000000 // elapsed:>8} glyphs/s")
+
+    time.sleep(5)
+    display.deinit()
+
+
+main()
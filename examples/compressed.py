@@ -0,0 +1,81 @@
+"""
+ST7701 Compressed Frame Example
+A kiosk-style status screen kept as run-length coded rows instead of an
+820KB framebuffer, with a clock band updated once a second.
+
+The screen is drawn once, a band at a time, then only the clock's rows are
+decoded, redrawn and coded again each second.
+"""
+
+import st7701
+import framebuf
+import time
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+BACKGROUND = st7701.rgb565(0, 0, 40)
+PANEL = st7701.rgb565(40, 40, 80)
+ACCENT = st7701.rgb565(255, 160, 0)
+
+CLOCK_Y = 380
+CLOCK_ROWS = 48
+
+
+def draw_band(display, y, rows, draw):
+    """Draw into rows [y, y + rows) with framebuf and commit them"""
+    band = display.edit(y, rows)
+    fb = framebuf.FrameBuffer(band, display.width(), rows, framebuf.RGB565)
+    draw(fb)
+    return display.commit()
+
+
+def header(fb):
+    fb.fill(ACCENT)
+    fb.text("STATUS", 20, 24, st7701.BLACK)
+
+
+def tiles(fb):
+    fb.fill(BACKGROUND)
+    for i in range(4):
+        fb.fill_rect(20 + (i % 2) * 230, 10 + (i // 2) * 110, 210, 100, PANEL)
+        fb.text(f"Zone {i + 1}: OK", 40 + (i % 2) * 230, 55 + (i // 2) * 110, st7701.WHITE)
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS,
+                            compressed=128 * 1024, background=BACKGROUND)
+    display.init()
+
+    rows, size, us = draw_band(display, 0, 64, header)
+    print(f"header: {rows} rows coded in {us} us, picture {size} bytes")
+    rows, size, us = draw_band(display, 120, 230, tiles)
+    print(f"tiles:  {rows} rows coded in {us} us, picture {size} bytes")
+
+    start = time.ticks_ms()
+    for _ in range(10):
+        seconds = time.ticks_diff(time.ticks_ms(), start) // 1000
+
+        def clock(fb):
+            fb.fill(BACKGROUND)
+            fb.text(f"Uptime {seconds // 60:02}:{seconds % 60:02}", 160, 20, st7701.WHITE)
+
+        rows, size, us = draw_band(display, CLOCK_Y, CLOCK_ROWS, clock)
+        print(f"clock:  {rows} rows changed, {us} us, picture {size} bytes "
+              f"({size * 100 // (display.width() * display.height() * 2)}% of a framebuffer)")
+        time.sleep_ms(1000)
+
+    display.deinit()
+
+
+main()
@@ -0,0 +1,64 @@
+"""
+ST7701 Landscape Example
+Draws a landscape (854x480) screen on the portrait panel with orientation=90,
+then checks the scan-out keeps up at several pixel clocks.
+
+The framebuffer is never rotated: each bounce buffer fill reads a strip of
+framebuffer columns and writes it out as panel rows. That costs more than a
+straight copy, so scanout_stats() reports whether every fill finished in time.
+"""
+
+import st7701
+import time
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+
+def draw(canvas):
+    width, height = canvas.width(), canvas.height()
+    canvas.fill(st7701.rgb565(20, 20, 40))
+    for i in range(8):
+        canvas.fill_rect(20 + i * 104, height - 60 - i * 40, 80, 40 + i * 40, st7701.rgb565(255 - i * 30, i * 30, 80))
+    canvas.hline(0, 0, width, st7701.WHITE)
+    canvas.hline(0, height - 1, width, st7701.WHITE)
+    canvas.vline(0, 0, height, st7701.RED)           # left edge of the landscape screen
+    canvas.fill_rect(0, 0, 40, 40, st7701.GREEN)     # top-left corner
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS,
+                            orientation=90)
+    display.init()
+    print(f"Framebuffer {display.width()}x{display.height()}")
+
+    canvas = st7701.Canvas(display)
+    draw(canvas)
+
+    print("Bounce fill time against the pixel clock...")
+    for pclk in (30_000_000, 24_000_000, 18_000_000, 12_000_000):
+        display.refresh(pclk)
+        time.sleep_ms(100)
+        display.scanout_stats(True)
+        time.sleep(2)
+        fills, mean_us, max_us, budget_us, overruns = display.scanout_stats()
+        verdict = "ok" if overruns == 0 else f"{overruns} late"
+        print(f"  {pclk / 1e6:>4.0f} MHz  mean {mean_us:>3} us  max {max_us:>3} us  "
+              f"budget {budget_us:>3} us  {fills} fills, {verdict}")
+
+    display.refresh(30_000_000)
+    time.sleep(5)
+    display.deinit()
+
+
+main()
@@ -0,0 +1,113 @@
+"""
+ST7701 Scene Example
+A scrolling tile layer with bouncing sprites, repainted natively.
+
+Only the screen cells touched by sprite movement or scrolling are
+repainted each frame - the number of pixels touched is printed so you can
+budget frame time.
+"""
+
+import st7701
+import framebuf
+import time
+from array import array
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+TILE = 32
+TRANSPARENT = 0xF81F    # magenta
+
+
+def make_sheet():
+    """Four 32x32 tiles side by side: grass, dirt, water, stone"""
+    colours = [
+        (st7701.rgb565(40, 140, 40), st7701.rgb565(30, 110, 30)),
+        (st7701.rgb565(130, 90, 50), st7701.rgb565(110, 75, 40)),
+        (st7701.rgb565(40, 80, 200), st7701.rgb565(60, 110, 230)),
+        (st7701.rgb565(120, 120, 120), st7701.rgb565(90, 90, 90)),
+    ]
+    sheet = bytearray(TILE * len(colours) * TILE * 2)
+    fb = framebuf.FrameBuffer(sheet, TILE * len(colours), TILE, framebuf.RGB565)
+    for i, (base, detail) in enumerate(colours):
+        fb.fill_rect(i * TILE, 0, TILE, TILE, base)
+        fb.rect(i * TILE, 0, TILE, TILE, detail)
+        fb.fill_rect(i * TILE + 10, 10, 6, 6, detail)
+    return sheet, TILE * len(colours)
+
+
+def make_ball(size, colour):
+    """Round sprite on a transparent background"""
+    buf = bytearray(size * size * 2)
+    fb = framebuf.FrameBuffer(buf, size, size, framebuf.RGB565)
+    fb.fill(TRANSPARENT)
+    r = size // 2 - 1
+    fb.ellipse(size // 2, size // 2, r, r, colour, True)
+    fb.ellipse(size // 2 - r // 3, size // 2 - r // 3, r // 4, r // 4, st7701.WHITE, True)
+    return buf
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS)
+    display.init()
+    width, height = display.width(), display.height()
+
+    sheet, sheet_w = make_sheet()
+
+    # 32x32 tile map, 16-bit indices
+    map_w, map_h = 32, 32
+    tiles = array('H', ((x * 7 + y * 3) // 5 % 4 for y in range(map_h) for x in range(map_w)))
+
+    scene = st7701.Scene(display, sheet, sheet_w, TILE, TILE, tiles, map_w, map_h)
+
+    balls = []
+    for i, colour in enumerate((st7701.RED, st7701.rgb565(255, 200, 0), st7701.rgb565(255, 0, 255))):
+        size = 40 + i * 12
+        scene.sprite(i, make_ball(size, colour), size, size, TRANSPARENT)
+        scene.z(i, i)
+        balls.append([i * 90, i * 150, 3 + i, 2 + i, size])
+
+    print("Scene demo...")
+    for frame in range(600):
+        for i, b in enumerate(balls):
+            x, y, dx, dy, size = b
+            if not 0 <= x + dx <= width - size:
+                b[2] = dx = -dx
+            if not 0 <= y + dy <= height - size:
+                b[3] = dy = -dy
+            b[0], b[1] = x + dx, y + dy
+            scene.move(i, b[0], b[1])
+
+        # Scroll slowly for the second half
+        if frame >= 300:
+            scene.scroll(frame - 300, 0)
+
+        # Change a tile now and again
+        if frame % 50 == 0:
+            scene.set_tile(frame // 50 % map_w, 3, frame // 50 % 4)
+
+        start = time.ticks_us()
+        touched = scene.render()
+        elapsed = time.ticks_diff(time.ticks_us(), start)
+
+        if frame % 60 == 0:
+            repainted, shifted, cells = scene.stats()
+            print(f"  frame {frame}: {touched} px touched "
+                  f"({repainted} repainted, {shifted} shifted, {cells} cells) in {elapsed} us")
+
+        time.sleep_ms(16)
+
+    display.deinit()
+
+
+main()
@@ -0,0 +1,38 @@
+"""
+ST7701 Scratch Arena Example
+Times rotate() by 90 degrees on images of a few sizes, with the scratch
+arena and without it, and prints the arena statistics.
+
+An image that fits in the arena is copied there and written back rotated
+a row at a time. One that doesn't is rotated in place in PSRAM by
+following cycles of the transpose, which needs no memory but is slow.
+"""
+
+import st7701
+import time
+
+SIZES = [(32, 32), (64, 48), (120, 100), (160, 200)]
+
+
+def time_rotate(w, h):
+    buf = bytearray(w * h * 2)
+    for i in range(0, len(buf), 7):
+        buf[i] = i & 0xFF
+    start = time.ticks_us()
+    st7701.rotate(buf, w, h, 90)
+    return time.ticks_diff(time.ticks_us(), start)
+
+
+def main():
+    for size in (0, 32 * 1024, 64 * 1024):
+        st7701.scratch(size)
+        print(f"arena {size // 1024}KB")
+        for w, h in SIZES:
+            print(f"  {w}x{h}: {time_rotate(w, h)} us")
+        size, high_water, allocs, shorts, fails = st7701.scratch_stats()
+        print(f"  high water {high_water}, {allocs} allocations, {shorts} short, {fails} failed")
+
+    st7701.scratch(32 * 1024)
+
+
+main()
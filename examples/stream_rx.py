@@ -0,0 +1,77 @@
+"""
+ST7701 Stream Receiver Example
+Shows frames streamed from a PC by utils/stream.py.
+
+Over USB-CDC (the REPL port) - run this, then close the REPL terminal and:
+    python utils/stream.py frame*.raw --port /dev/ttyACM0 --loop 0
+
+Over a UART - set UART_RX below, then:
+    python utils/stream.py frame*.raw --port /dev/ttyUSB0 --baud 2000000 --loop 0
+"""
+
+import st7701
+import sys
+import time
+import micropython
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+UART_PORT = 1
+UART_RX   = -1          # set to a pin number to receive over a UART instead of USB-CDC
+UART_BAUD = 2000000
+
+
+def report(rx, start):
+    frames, rects, received, errors = rx.stats()
+    elapsed = time.ticks_diff(time.ticks_ms(), start) / 1000
+    print(f"  {frames} frames ({frames / elapsed:.1f} fps), {rects} rects, "
+          f"{received // 1024} KB, {errors} errors")
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS, buffers=2)
+    display.init()
+
+    rx = st7701.StreamReceiver(display)
+    start = time.ticks_ms()
+
+    if UART_RX >= 0:
+        rx.uart(UART_PORT, UART_BAUD, UART_RX)
+        print("Receiving on UART, Ctrl-C to stop...")
+        try:
+            while True:
+                time.sleep(5)
+                report(rx, start)
+        except KeyboardInterrupt:
+            pass
+        rx.stop()
+    else:
+        # The stream is binary, so stop Ctrl-C (0x03) from interrupting it.
+        # Reset the board to get the REPL back.
+        print("Receiving on USB-CDC...")
+        micropython.kbd_intr(-1)
+        # readinto() waits for a full buffer, so keep it small to limit how
+        # long the end of a frame can sit unread
+        buf = bytearray(512)
+        stdin = sys.stdin.buffer
+        while True:
+            n = stdin.readinto(buf)
+            if n:
+                rx.feed(memoryview(buf)[:n])
+
+    report(rx, start)
+    display.deinit()
+
+
+main()
@@ -0,0 +1,55 @@
+"""
+ST7701 Trace Example
+Records a few double-buffered frames and writes a Chrome trace to
+trace.json. Copy it to a PC (e.g. mpremote cp :trace.json .) and open it in
+https://ui.perfetto.dev or chrome://tracing.
+
+Native calls and bounce buffer fills are recorded by the driver. trace_mark()
+adds spans for the Python side, so the gaps between native calls show where
+interpreter time goes.
+"""
+
+import st7701
+import time
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+FRAMES = 10
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS, buffers=2)
+    display.init()
+    canvas = st7701.Canvas(display)
+
+    # About 120 bounce fills per frame, so keep room for all of them
+    st7701.trace_begin(4096)
+    for frame in range(FRAMES):
+        st7701.trace_mark("frame", "B")
+        canvas.fill(st7701.BLACK)
+        for i in range(20):
+            canvas.fill_rect((frame * 8 + i * 23) % 440, i * 40, 40, 30, st7701.rgb565(255, i * 12, 0))
+        st7701.trace_mark("frame", "E")
+        display.flip()
+    recorded, lost = st7701.trace_end()
+    print(f"{recorded} events recorded, {lost} overwritten")
+
+    written = st7701.trace_dump("trace.json")
+    print(f"{written} events written to trace.json")
+
+    time.sleep(2)
+    display.deinit()
+
+
+main()
@@ -0,0 +1,76 @@
+"""
+ST7701 Screen Transition Example
+Runs every kind of transition between two screens and prints how smoothly
+each one ran.
+
+The two screens are ordinary RGB565 buffers in PSRAM, drawn once with a
+Canvas. The transitions are done natively on the other core, so nothing
+happens in Python between the frames.
+"""
+
+import st7701
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+DURATION_MS = 400
+
+KINDS = [
+    ("slide", st7701.TRANSITION_SLIDE),
+    ("wipe", st7701.TRANSITION_WIPE),
+    ("push", st7701.TRANSITION_PUSH),
+    ("crossfade", st7701.TRANSITION_CROSSFADE),
+]
+
+DIRECTIONS = [
+    ("left", st7701.TRANSITION_LEFT),
+    ("right", st7701.TRANSITION_RIGHT),
+    ("up", st7701.TRANSITION_UP),
+    ("down", st7701.TRANSITION_DOWN),
+]
+
+
+def make_screen(w, h, colour, stripe):
+    """A full screen of colour with diagonal stripes, so movement is easy to see"""
+    buf = bytearray(w * h * 2)
+    canvas = st7701.Canvas(buf, w, h)
+    canvas.fill(colour)
+    for x in range(-h, w, 60):
+        for y in range(0, h, 4):
+            canvas.fill_rect(x + y, y, 20, 4, stripe)
+    return buf
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS,
+                            buffers=2)
+    display.init()
+    w, h = display.width(), display.height()
+
+    a = make_screen(w, h, st7701.rgb565(0, 40, 120), st7701.rgb565(0, 90, 200))
+    b = make_screen(w, h, st7701.rgb565(140, 60, 0), st7701.rgb565(230, 140, 0))
+
+    print(f"{'':20} steps dropped    fps")
+    screens = (a, b)
+    for name, kind in KINDS:
+        for dir_name, direction in DIRECTIONS:
+            steps, dropped, fps = display.transition(screens[0], screens[1], kind, DURATION_MS, direction=direction)
+            print(f"{name + ' ' + dir_name:20} {steps:5} {dropped:7} {fps:6.1f}")
+            screens = screens[::-1]
+            if kind == st7701.TRANSITION_CROSSFADE:
+                break       # no direction
+
+    display.deinit()
+
+
+main()
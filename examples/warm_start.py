@@ -0,0 +1,49 @@
+"""
+ST7701 Warm Start Example
+Measures time-to-first-frame for cold and warm starts.
+
+Run it once after a hard reset (cold start), then soft reset with Ctrl-D and
+run it again (warm start). The panel and framebuffer are reused on the
+second run, skipping the reset, the init sequence and the PSRAM allocation.
+"""
+
+import st7701
+import time
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+
+def main():
+    start = time.ticks_us()
+
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS)
+    warm = display.init()
+    init_done = time.ticks_us()
+
+    canvas = st7701.Canvas(display)
+    canvas.fill_rect(0, 0, display.width(), display.height() // 2, st7701.BLUE)
+    display.flip()      # single buffer - waits for the next frame to start
+    first_frame = time.ticks_us()
+
+    print(f"{'Warm' if warm else 'Cold'} start:")
+    print(f"  init()            {time.ticks_diff(init_done, start) // 1000:>5} ms")
+    print(f"  first frame       {time.ticks_diff(first_frame, start) // 1000:>5} ms")
+
+    # Park the panel for the next run rather than freeing it
+    time.sleep(2)
+    display.deinit()
+    print("Soft reset (Ctrl-D) and run again for a warm start")
+
+
+main()
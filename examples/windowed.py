@@ -0,0 +1,70 @@
+"""
+ST7701 Windowed Mode Example
+A clock and a bar graph in two windows on a gradient background.
+
+Only the two windows have pixels (about 110KB, in internal SRAM if it fits);
+the scan-out repeats one gradient row down the rest of the screen, so no
+framebuffer is allocated in PSRAM at all.
+"""
+
+import st7701
+import framebuf
+import time
+
+SPI_CS   = 41
+SPI_CLK  = 42
+SPI_MOSI = 2
+RESET    = 1
+BACKLIGHT = -1
+
+PCLK  = 40
+HSYNC = 5
+VSYNC = 38
+DE    = 39
+
+DATA_PINS = [12, 47, 21, 14, 4,  11, 10, 9, 3, 8, 18,  7, 17, 16, 15, 13]
+
+CLOCK = (40, 120, 400, 48)
+GRAPH = (40, 500, 400, 120)
+
+
+def gradient_row(width):
+    """One row of width pixels, dark blue at the edges and lighter in the middle"""
+    row = bytearray(width * 2)
+    view = memoryview(row).cast('H')
+    for x in range(width):
+        level = 255 - abs(x - width // 2) * 255 // (width // 2)
+        view[x] = st7701.rgb565(0, level // 4, 40 + level // 2)
+    return row
+
+
+def main():
+    display = st7701.ST7701(SPI_CS, SPI_CLK, SPI_MOSI, RESET, BACKLIGHT, PCLK, HSYNC, VSYNC, DE, DATA_PINS,
+                            windows=[CLOCK, GRAPH])
+    display.init()
+    display.background(gradient_row(display.width()))
+
+    clock = framebuf.FrameBuffer(display.window(0), CLOCK[2], CLOCK[3], framebuf.RGB565)
+    graph = st7701.Canvas(display.window(1), GRAPH[2], GRAPH[3])
+
+    bars = [0] * 20
+    start = time.ticks_ms()
+    for i in range(200):
+        seconds = time.ticks_diff(time.ticks_ms(), start) // 1000
+        clock.fill(st7701.BLACK)
+        clock.text(f"{seconds // 60:02}:{seconds % 60:02}  frame {i}", 16, 20, st7701.WHITE)
+
+        # Scroll the bars left and add a new one
+        bars = bars[1:] + [(i * 37) % GRAPH[3]]
+        graph.fill(st7701.rgb565(20, 20, 20))
+        for n, h in enumerate(bars):
+            graph.fill_rect(n * 20 + 2, GRAPH[3] - h, 16, h, st7701.rgb565(255, 160, 0))
+
+        display.activity()      # drawn into the windows directly
+        display.flip()          # single buffer - waits for the next frame
+        time.sleep_ms(50)
+
+    display.deinit()
+
+
+main()
@@ -1,7 +1,8 @@
 /*
  * ST7701 RGB LCD Driver for MicroPython
  * 
- * Hardware setup only - use framebuf for drawing.
+ * Hardware setup and scan-out. Use framebuf or the native drawing engines
+ * (st7701_*.c) for drawing.
  * Targets ESP32-S3 with esp_lcd RGB panel interface.
  * Display: 480x854 RGB565
  */
@@ -9,19 +10,35 @@
 #include "py/runtime.h"
 #include "py/obj.h"
 #include "py/mphal.h"
+#include "py/stream.h"
+#include "py/mperrno.h"
 
 #include "esp_lcd_panel_rgb.h"
 #include "esp_lcd_panel_ops.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "st7701.h"
 
 static const char *TAG = "ST7701";
 
 #define LCD_H_RES 480
 #define LCD_V_RES 854
 
+// Pixel clocks per line and lines per frame - the visible area plus the sync
+// pulses and porches set in setup_rgb_panel()
+#define LINE_CLOCKS   (LCD_H_RES + 70)
+#define FRAME_LINES   (LCD_V_RES + 32)
+
 // Color definitions (RGB565)
 #define COLOR_BLACK   0x0000
 #define COLOR_WHITE   0xFFFF
@@ -29,36 +46,177 @@ static const char *TAG = "ST7701";
 #define COLOR_GREEN   0x07E0
 #define COLOR_BLUE    0x001F
 
+// Bounce buffer height in lines - 854 = 2 * 7 * 61, so 7 lines divides the frame
+#define BOUNCE_LINES  7
+
+#define MAX_OVERLAYS  4
+
+// Pixel clock. One frame is 550 x 886 clocks with the porches below, so
+// 30 MHz refreshes at about 61.6 Hz.
+#define PCLK_HZ       30000000
+#define PCLK_MIN_HZ   1000000
+#define PCLK_MAX_HZ   40000000
+#define PCLK_IDLE_HZ  8000000     // default idle rate, about 16 Hz
+
+// How often the idle timer looks at the frame count
+#define IDLE_CHECK_US 20000
+
+// Overlay pixel formats
+#define OVERLAY_RGB565  0   // RGB565 pixels, optional transparent colour key
+#define OVERLAY_A8      1   // 8-bit coverage mask drawn in a single colour
+
 // ============================================================================
-// ST7701 Display Object
+// Scan-out State
 // ============================================================================
 
-typedef struct _st7701_obj_t {
-    mp_obj_base_t base;
-    esp_lcd_panel_handle_t panel_handle;
-    uint16_t *framebuffer;
-    uint16_t width;
+// A small plane composited on top of the framebuffer while the bounce buffers
+// are filled. The pixels are copied into internal SRAM so the ISR never touches
+// the MicroPython heap.
+typedef struct _st7701_overlay_t {
+    void *pixels;           // uint16_t (RGB565) or uint8_t (A8), NULL if unused
+    uint16_t w;
+    uint16_t h;
+    uint8_t format;
+    int32_t key;            // RGB565: transparent colour, -1 for none
+    uint16_t colour;        // A8: colour the mask is drawn in
+
+    // Position/visibility/opacity requested from Python (or an animation),
+    // latched at the start of a frame
+    int16_t next_x;
+    int16_t next_y;
+    bool next_visible;
+    uint8_t next_alpha;
+
+    // Position/visibility/opacity used by the scan-out of the current frame
+    int16_t x;
+    int16_t y;
+    bool visible;
+    uint8_t alpha;          // 0-32, blend565() scale, 32 = opaque
+} st7701_overlay_t;
+
+// Per-channel colour lookup, indexed by the 5/6/5-bit channel value. Entries
+// are pre-shifted into place so a pixel maps with three loads and two ORs.
+typedef struct _st7701_lut_t {
+    uint16_t r[32];
+    uint16_t g[64];
+    uint16_t b[32];
+} st7701_lut_t;
+
+// Everything the panel ISR reads. There is only one RGB LCD peripheral, so this
+// is a single static instance rather than part of the (GC-allocated) object -
+// the ISR keeps running across a soft reset and must never see freed memory.
+typedef struct _st7701_scanout_t {
+    uint16_t *front;        // buffer being scanned out
+    uint16_t *volatile pending_front;   // becomes front at the start of the next frame
+    volatile bool blank;                // send black instead of the framebuffer
+    uint16_t width;                     // framebuffer size, as drawn (854x480 in landscape)
     uint16_t height;
-    
-    // SPI pins for init
-    gpio_num_t spi_cs;
-    gpio_num_t spi_clk;
-    gpio_num_t spi_mosi;
-    gpio_num_t reset;
-    gpio_num_t backlight;
-    
-    // RGB pins
-    gpio_num_t pclk;
-    gpio_num_t hsync;
-    gpio_num_t vsync;
-    gpio_num_t de;
-    gpio_num_t data[16];
+    uint16_t orientation;               // rotation on the way to the panel: 0, 90, 180 or 270
+    volatile uint32_t frame_count;      // incremented at the start of every frame
+    volatile uint32_t frame_start_us;   // esp_timer time of the last frame start (low 32 bits)
+    SemaphoreHandle_t frame_sem;        // given at the start of every frame
+    TaskHandle_t volatile waiter;       // task to wake at the start of a frame (asyncio)
+    st7701_overlay_t overlays[MAX_OVERLAYS];
+    st7701_tween_t overlay_tweens[MAX_OVERLAYS][ANIM_OPACITY + 1];  // by ANIM_POS / ANIM_OPACITY
+    portMUX_TYPE anim_lock;             // held while the overlay tweens are stepped or changed
+    
+    // Windowed mode (front is NULL): only the windows have pixels, everything
+    // else is generated from a solid colour or a row repeated down the screen
+    st7701_overlay_t windows[ST7701_MAX_WINDOWS];
+    volatile uint8_t num_windows;
+    uint16_t background;
+    uint16_t *volatile background_row;  // width pixels, NULL for a solid colour
+    
+    // Compressed mode (front is NULL): the framebuffer rows are run-length
+    // coded, one pointer per row, and decoded as they are sent
+    const uint16_t *const *volatile rows;           // NULL if not compressed
+    const uint16_t *const *volatile pending_rows;   // becomes rows at the start of the next frame
+    
+    // Colour LUT - built from the inputs below into the inactive table and
+    // swapped in at the start of a frame
+    st7701_lut_t luts[2];
+    const st7701_lut_t *lut;            // NULL when the LUT is the identity
+    volatile bool lut_dirty;
+    uint8_t curve_r[32];                // user curves, in channel units
+    uint8_t curve_g[64];
+    uint8_t curve_b[32];
+    bool curve_identity;
+    uint8_t gain_r;                     // per-channel gain (tint), 255 = 1.0
+    uint8_t gain_g;
+    uint8_t gain_b;
+    uint8_t brightness;                 // 255 = full
+    uint32_t fade;                      // current fade level, 16.16 fixed point (255 << 16 = none)
+    int32_t fade_step;                  // added to fade every frame while fade_frames > 0
+    volatile uint32_t fade_frames;
+    
+    // Bounce fill timing. A fill has to finish while the other bounce
+    // buffer is sent, or the panel is sent stale lines.
+    uint32_t fill_budget;               // CPU cycles per fill at the current pixel clock
+    uint32_t fills;
+    uint64_t fill_cycles;               // total over all fills
+    uint32_t fill_max;
+    uint32_t overruns;                  // fills that took longer than fill_budget
+} st7701_scanout_t;
+
+// Where the pixels of a framebuffer rectangle land in a compose buffer:
+// pixel (x, y) goes to dst[base + x * sx + y * sy]. This is how rotated
+// orientations are produced without a rotated copy of the framebuffer.
+typedef struct _compose_map_t {
+    int x0;                 // area covered, in framebuffer coordinates
+    int y0;
+    int x1;
+    int y1;
+    int base;
+    int sx;
+    int sy;
+} compose_map_t;
+
+static st7701_scanout_t scanout = {
+    .anim_lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+// Set while a capture needs the front buffer to stay put
+static volatile bool flip_hold;
+
+// The RGB panel and framebuffers outlive the display object: deinit() parks
+// them here, and they survive a soft reset, so the next init() on the same
+// pins can skip the reset and init sequence and reuse the PSRAM instead of
+// allocating it again. A soft reset runs every object's finaliser, and the
+// display's parks the panel the same way deinit() does.
+#define PERSIST_PINS  24
+
+typedef struct _st7701_persist_t {
+    esp_lcd_panel_handle_t panel;       // NULL if there is nothing to reuse
+    uint16_t *buffers[2];
+    uint8_t num_buffers;
+    gpio_num_t pins[PERSIST_PINS];      // pins the panel was set up on
+    st7701_obj_t *owner;                // display object driving it, NULL while parked
+} st7701_persist_t;
 
-    // Cached framebuffer memoryview
-    mp_obj_t fb_obj;
-} st7701_obj_t;
+static st7701_persist_t persist;
 
-const mp_obj_type_t st7701_type;
+// Refresh rate. The scan-out reads the whole frame from PSRAM on every
+// refresh, even when nothing has changed, so after idle_frames frames without
+// drawing the pixel clock drops to low_pclk_hz and leaves the bandwidth to
+// everything else. The next draw or flip restores it. A new clock takes
+// effect at the start of the next frame; the panel itself is not touched.
+typedef struct _st7701_refresh_t {
+    esp_lcd_panel_handle_t panel;       // NULL while there is no panel
+    uint32_t pclk_hz;                   // rate while the picture is changing
+    uint32_t low_pclk_hz;               // rate once idle
+    uint32_t idle_frames;               // frames without drawing before dropping, 0 = never
+    uint32_t active_frame;              // scanout.frame_count at the last draw
+    bool low;                           // running at low_pclk_hz
+    uint32_t changes;                   // bumped by every change of the clock wanted
+    portMUX_TYPE lock;                  // shared with the idle timer
+    esp_timer_handle_t timer;
+} st7701_refresh_t;
+
+static st7701_refresh_t refresh = {
+    .pclk_hz = PCLK_HZ,
+    .low_pclk_hz = PCLK_IDLE_HZ,
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
 
 // ============================================================================
 // 9-bit SPI bit-bang for init sequence
@@ -271,20 +429,537 @@ static void setup_backlight(st7701_obj_t *self, bool on) {
     }
 }
 
+// ============================================================================
+// Scan-out (bounce buffer fill)
+// ============================================================================
+
+// Copy n pixels to out, step pixels apart
+static inline void IRAM_ATTR copy_span(uint16_t *out, int step, const uint16_t *src, int n) {
+    if (step == 1) {
+        memcpy(out, src, n * 2);
+    } else {
+        for (int i = 0; i < n; i++) {
+            *out = src[i];
+            out += step;
+        }
+    }
+}
+
+// Composite one overlay onto the area of the framebuffer held in dst
+static void IRAM_ATTR composite_overlay(const st7701_overlay_t *ov, uint16_t *dst, const compose_map_t *m) {
+    int oy0 = ov->y > m->y0 ? ov->y : m->y0;
+    int oy1 = ov->y + ov->h < m->y1 ? ov->y + ov->h : m->y1;
+    int ox0 = ov->x > m->x0 ? ov->x : m->x0;
+    int ox1 = ov->x + ov->w < m->x1 ? ov->x + ov->w : m->x1;
+    if (oy0 >= oy1 || ox0 >= ox1) {
+        return;
+    }
+    
+    int step = m->sx;
+    uint32_t opacity = ov->alpha;
+    for (int y = oy0; y < oy1; y++) {
+        uint16_t *out = dst + m->base + ox0 * m->sx + y * m->sy;
+        int src_off = (y - ov->y) * ov->w + (ox0 - ov->x);
+        int n = ox1 - ox0;
+        
+        if (ov->format == OVERLAY_A8) {
+            const uint8_t *a = (const uint8_t *)ov->pixels + src_off;
+            for (int i = 0; i < n; i++, out += step) {
+                uint32_t alpha = ((a[i] + 4) >> 3) * opacity >> 5;
+                if (alpha >= 32) {
+                    *out = ov->colour;
+                } else if (alpha) {
+                    *out = blend565(ov->colour, *out, alpha);
+                }
+            }
+        } else if (opacity < 32) {
+            // Partly transparent: blend every pixel not keyed out
+            const uint16_t *p = (const uint16_t *)ov->pixels + src_off;
+            for (int i = 0; i < n; i++, out += step) {
+                if (ov->key < 0 || p[i] != (uint16_t)ov->key) {
+                    *out = blend565(p[i], *out, opacity);
+                }
+            }
+        } else if (ov->key < 0) {
+            copy_span(out, step, (const uint16_t *)ov->pixels + src_off, n);
+        } else {
+            const uint16_t *p = (const uint16_t *)ov->pixels + src_off;
+            uint16_t key = ov->key;
+            for (int i = 0; i < n; i++, out += step) {
+                if (p[i] != key) {
+                    *out = p[i];
+                }
+            }
+        }
+    }
+}
+
+// Scale one channel table through the user curve and a combined 0..255*255 factor
+static void IRAM_ATTR lut_build_channel(uint16_t *out, const uint8_t *curve, int n,
+                                        bool identity, uint32_t factor, int shift) {
+    for (int v = 0; v < n; v++) {
+        uint32_t c = identity ? v : curve[v];
+        c = (c * factor + 255 * 255 / 2) / (255 * 255);
+        if (c >= (uint32_t)n) {
+            c = n - 1;
+        }
+        out[v] = c << shift;
+    }
+}
+
+// Rebuild the colour LUT from the curves, gains, brightness and fade level.
+// Runs at frame start, so a fade costs 128 table entries per frame.
+static void IRAM_ATTR lut_build(st7701_scanout_t *so) {
+    uint32_t level = ((so->fade >> 16) * so->brightness + 127) / 255;
+    
+    if (so->curve_identity && level == 255 &&
+        so->gain_r == 255 && so->gain_g == 255 && so->gain_b == 255) {
+        so->lut = NULL;
+        return;
+    }
+    
+    st7701_lut_t *lut = so->lut == &so->luts[0] ? &so->luts[1] : &so->luts[0];
+    lut_build_channel(lut->r, so->curve_r, 32, so->curve_identity, so->gain_r * level, 11);
+    lut_build_channel(lut->g, so->curve_g, 64, so->curve_identity, so->gain_g * level, 5);
+    lut_build_channel(lut->b, so->curve_b, 32, so->curve_identity, so->gain_b * level, 0);
+    so->lut = lut;
+}
+
+// The framebuffer area shown on panel rows [py, py + rows), and where each
+// of its pixels goes in a buffer holding those rows. In the rotated
+// orientations a bounce fill covers a strip of framebuffer columns, read a
+// few contiguous pixels per row.
+static void IRAM_ATTR panel_map(const st7701_scanout_t *so, compose_map_t *m, int py, int rows) {
+    const int w = LCD_H_RES;
+    const int h = LCD_V_RES;
+    
+    switch (so->orientation) {
+        case 90:    // framebuffer x runs down the panel, y runs right to left
+            m->x0 = py;
+            m->x1 = py + rows;
+            m->y0 = 0;
+            m->y1 = w;
+            m->base = w - 1 - py * w;
+            m->sx = w;
+            m->sy = -1;
+            break;
+        case 180:
+            m->x0 = 0;
+            m->x1 = w;
+            m->y0 = h - py - rows;
+            m->y1 = h - py;
+            m->base = (h - 1 - py) * w + w - 1;
+            m->sx = -1;
+            m->sy = -w;
+            break;
+        case 270:   // framebuffer x runs up the panel, y runs left to right
+            m->x0 = h - py - rows;
+            m->x1 = h - py;
+            m->y0 = 0;
+            m->y1 = w;
+            m->base = (h - 1 - py) * w;
+            m->sx = -w;
+            m->sy = 1;
+            break;
+        default:
+            m->x0 = 0;
+            m->x1 = w;
+            m->y0 = py;
+            m->y1 = py + rows;
+            m->base = -py * w;
+            m->sx = 1;
+            m->sy = w;
+            break;
+    }
+}
+
+// Windowed mode: the background, then the windows on top
+static void IRAM_ATTR compose_windows(const st7701_scanout_t *so, uint16_t *dst, const compose_map_t *m, int len_px) {
+    const uint16_t *row = so->background_row;
+    if (row == NULL) {
+        // dst is exactly the area, whatever the orientation. The bounce
+        // buffers are word aligned and hold whole lines.
+        uint32_t c2 = so->background | ((uint32_t)so->background << 16);
+        uint32_t *d = (uint32_t *)dst;
+        for (int i = 0; i < len_px / 2; i++) {
+            d[i] = c2;
+        }
+    } else {
+        uint16_t *out = dst + m->base + m->x0 * m->sx + m->y0 * m->sy;
+        int n = m->x1 - m->x0;
+        for (int y = m->y0; y < m->y1; y++) {
+            copy_span(out, m->sx, row + m->x0, n);
+            out += m->sy;
+        }
+    }
+    
+    for (int i = 0; i < so->num_windows; i++) {
+        composite_overlay(&so->windows[i], dst, m);
+    }
+}
+
+// Decode one run-length coded row of n pixels to out, step pixels apart.
+// A row is a sequence of 16-bit words: a count with the top bit set is a
+// run of that many pixels of the colour in the next word, otherwise the
+// count is followed by that many literal pixels.
+static void IRAM_ATTR comp_decode_row(const uint16_t *src, uint16_t *out, int step, int n) {
+    while (n > 0) {
+        uint32_t head = *src++;
+        int count = head & 0x7FFF;
+        if (head & 0x8000) {
+            uint16_t c = *src++;
+            for (int i = 0; i < count; i++, out += step) {
+                *out = c;
+            }
+        } else {
+            copy_span(out, step, src, count);
+            src += count;
+            out += count * step;
+        }
+        n -= count;
+    }
+}
+
+// Compressed mode: whole rows, as the orientation is 0 or 180
+static void IRAM_ATTR compose_compressed(const st7701_scanout_t *so, uint16_t *dst, const compose_map_t *m) {
+    const uint16_t *const *rows = so->rows;
+    uint16_t *out = dst + m->base + m->y0 * m->sy;
+    for (int y = m->y0; y < m->y1; y++) {
+        comp_decode_row(rows[y], out, m->sx, so->width);
+        out += m->sy;
+    }
+}
+
+// Produce pixels exactly as they are sent to the panel: framebuffer (or
+// windows, or compressed rows), then overlays, then the colour LUT. m says
+// which area of the framebuffer to compose and where it goes in dst, which
+// holds len_px pixels.
+static void IRAM_ATTR compose(const st7701_scanout_t *so, uint16_t *dst, const compose_map_t *m, int len_px) {
+    if (so->blank) {
+        memset(dst, 0, len_px * 2);
+        return;
+    }
+    
+    if (so->front == NULL) {
+        if (so->rows != NULL) {
+            compose_compressed(so, dst, m);
+        } else {
+            compose_windows(so, dst, m, len_px);
+        }
+    } else {
+        const uint16_t *src = so->front + m->y0 * so->width + m->x0;
+        uint16_t *out = dst + m->base + m->x0 * m->sx + m->y0 * m->sy;
+        int n = m->x1 - m->x0;
+        for (int y = m->y0; y < m->y1; y++) {
+            copy_span(out, m->sx, src, n);
+            src += so->width;
+            out += m->sy;
+        }
+    }
+    
+    const st7701_lut_t *lut = so->lut;
+    
+    for (int i = 0; i < MAX_OVERLAYS; i++) {
+        const st7701_overlay_t *ov = &so->overlays[i];
+        if (ov->visible && ov->alpha > 0) {
+            composite_overlay(ov, dst, m);
+        }
+    }
+    
+    // Colour LUT is the last stage, so it applies to overlays too
+    if (lut != NULL) {
+        for (int i = 0; i < len_px; i++) {
+            uint16_t p = dst[i];
+            dst[i] = lut->r[p >> 11] | lut->g[(p >> 5) & 0x3F] | lut->b[p & 0x1F];
+        }
+    }
+}
+
+// Step an overlay's animations into the values latched for this frame
+static inline void IRAM_ATTR overlay_animate(st7701_overlay_t *ov, st7701_tween_t *tweens, uint32_t now_us) {
+    int32_t v[2];
+    if (tweens[ANIM_POS].active) {
+        st7701_tween_step(&tweens[ANIM_POS], now_us, v);
+        ov->next_x = v[0];
+        ov->next_y = v[1];
+    }
+    if (tweens[ANIM_OPACITY].active) {
+        st7701_tween_step(&tweens[ANIM_OPACITY], now_us, v);
+        int32_t level = v[0] < 0 ? 0 : (v[0] > 255 ? 255 : v[0]);   // EASE_OUT_BACK overshoots
+        ov->next_alpha = (level + 4) >> 3;
+    }
+}
+
+// Called by the RGB panel driver from ISR context whenever a bounce buffer
+// needs refilling. pos_px is the offset of the first pixel within the frame.
+static bool IRAM_ATTR st7701_on_bounce_empty(esp_lcd_panel_handle_t panel, void *bounce_buf,
+                                             int pos_px, int len_bytes, void *user_ctx) {
+    st7701_scanout_t *so = user_ctx;
+    BaseType_t need_yield = pdFALSE;
+    uint32_t start = esp_cpu_get_cycle_count();
+    
+    // Frame start: latch everything Python may have changed during the last
+    // frame, so a frame is always composited from one consistent state
+    if (pos_px == 0) {
+        uint32_t now_us = (uint32_t)esp_timer_get_time();
+        if (so->pending_front != NULL) {
+            so->front = so->pending_front;
+            so->pending_front = NULL;
+        }
+        if (so->pending_rows != NULL) {
+            so->rows = so->pending_rows;
+            so->pending_rows = NULL;
+        }
+        if (so->fade_frames > 0) {
+            so->fade += so->fade_step;
+            so->fade_frames--;
+            so->lut_dirty = true;
+        }
+        if (so->lut_dirty) {
+            so->lut_dirty = false;
+            lut_build(so);
+        }
+        // The ISR may run on the other core: once a tween has been stopped
+        // or replaced under the lock, it is not being stepped any more
+        portENTER_CRITICAL_ISR(&so->anim_lock);
+        for (int i = 0; i < MAX_OVERLAYS; i++) {
+            st7701_overlay_t *ov = &so->overlays[i];
+            overlay_animate(ov, so->overlay_tweens[i], now_us);
+            ov->x = ov->next_x;
+            ov->y = ov->next_y;
+            ov->visible = ov->next_visible && ov->pixels != NULL;
+            ov->alpha = ov->next_alpha;
+        }
+        portEXIT_CRITICAL_ISR(&so->anim_lock);
+        so->frame_count++;
+        so->frame_start_us = now_us;
+        xSemaphoreGiveFromISR(so->frame_sem, &need_yield);
+        if (so->waiter != NULL) {
+            // Wake MicroPython out of its event-loop wait, so the asyncio
+            // poller sees the frame now rather than at its next tick
+            vTaskNotifyGiveFromISR(so->waiter, &need_yield);
+        }
+        ST7701_TRACE_EVENT(MP_QSTR_frame_start, TRACE_FRAME, start, 0);
+    }
+    
+    compose_map_t m;
+    panel_map(so, &m, pos_px / LCD_H_RES, len_bytes / 2 / LCD_H_RES);
+    compose(so, bounce_buf, &m, len_bytes / 2);
+    
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    so->fills++;
+    so->fill_cycles += cycles;
+    if (cycles > so->fill_max) {
+        so->fill_max = cycles;
+    }
+    if (cycles > so->fill_budget) {
+        so->overruns++;
+    }
+    ST7701_TRACE_EVENT(MP_QSTR_bounce_fill, TRACE_SCANOUT, start, cycles);
+    
+    return need_yield == pdTRUE;
+}
+
+// Block until the scan-out has started a new frame (or the timeout expires)
+static bool scanout_wait_frame(uint32_t timeout_ms) {
+    if (scanout.frame_sem == NULL) {
+        return false;
+    }
+    xSemaphoreTake(scanout.frame_sem, 0);   // discard a stale frame start
+    return xSemaphoreTake(scanout.frame_sem, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+// Stop an overlay's animation of prop (-1 for all of them), leaving it
+// where it got to. Once this returns the scan-out won't write the
+// overlay's next_ values for it again.
+static void overlay_stop(st7701_overlay_t *ov, int prop) {
+    st7701_tween_t *tweens = scanout.overlay_tweens[ov - scanout.overlays];
+    portENTER_CRITICAL(&scanout.anim_lock);
+    for (int i = 0; i <= ANIM_OPACITY; i++) {
+        if (prop < 0 || prop == i) {
+            tweens[i].active = false;
+        }
+    }
+    portEXIT_CRITICAL(&scanout.anim_lock);
+}
+
+// Free an overlay's pixels. Only call once the scan-out can no longer see it.
+static void overlay_release(st7701_overlay_t *ov) {
+    void *pixels = ov->pixels;
+    overlay_stop(ov, -1);
+    ov->next_visible = false;
+    ov->visible = false;
+    ov->pixels = NULL;
+    heap_caps_free(pixels);
+}
+
+// Start the fill timing statistics again
+static void scanout_stats_reset(void) {
+    scanout.fills = 0;
+    scanout.fill_cycles = 0;
+    scanout.fill_max = 0;
+    scanout.overruns = 0;
+}
+
+// Reset the colour LUT to the identity
+static void lut_reset(st7701_scanout_t *so) {
+    so->fade_frames = 0;
+    so->lut = NULL;
+    so->curve_identity = true;
+    so->gain_r = so->gain_g = so->gain_b = 255;
+    so->brightness = 255;
+    so->fade = 255 << 16;
+    so->lut_dirty = false;
+}
+
+// ============================================================================
+// Adaptive Refresh
+// ============================================================================
+
+// Change the pixel clock from the next frame, and the time a bounce fill
+// has at the new rate
+static void panel_set_pclk(esp_lcd_panel_handle_t panel, uint32_t pclk_hz) {
+    if (panel != NULL) {
+        esp_lcd_rgb_panel_set_pclk(panel, pclk_hz);
+    }
+    uint64_t cpu_hz = esp_rom_get_cpu_ticks_per_us() * 1000000ULL;
+    scanout.fill_budget = BOUNCE_LINES * LINE_CLOCKS * cpu_hz / pclk_hz;
+}
+
+// Give the panel the clock the refresh state wants. Changes are decided
+// under the lock but applied outside it, as the driver call can't be made
+// in a critical section; if another change came in meanwhile (from the idle
+// timer or the other task), apply again so the last one decided wins.
+static void refresh_apply(esp_lcd_panel_handle_t panel) {
+    for (;;) {
+        portENTER_CRITICAL(&refresh.lock);
+        uint32_t changes = refresh.changes;
+        uint32_t pclk = refresh.low ? refresh.low_pclk_hz : refresh.pclk_hz;
+        portEXIT_CRITICAL(&refresh.lock);
+
+        panel_set_pclk(panel, pclk);
+
+        portENTER_CRITICAL(&refresh.lock);
+        bool done = refresh.changes == changes;
+        portEXIT_CRITICAL(&refresh.lock);
+        if (done) {
+            return;
+        }
+    }
+}
+
+// Runs on the esp_timer task: drop to the idle rate once enough frames have
+// gone by without drawing
+static void refresh_idle_check(void *arg) {
+    bool drop = false;
+    portENTER_CRITICAL(&refresh.lock);
+    if (refresh.panel != NULL && !refresh.low && refresh.idle_frames > 0 &&
+        scanout.frame_count - refresh.active_frame >= refresh.idle_frames) {
+        refresh.low = true;
+        refresh.changes++;
+        drop = true;
+    }
+    esp_lcd_panel_handle_t panel = refresh.panel;
+    portEXIT_CRITICAL(&refresh.lock);
+    if (drop) {
+        refresh_apply(panel);
+    }
+}
+
+// Back to the full default rate with the idle policy off, on panel (or NULL
+// when the panel is going away)
+static void refresh_reset(esp_lcd_panel_handle_t panel) {
+    if (refresh.timer != NULL) {
+        esp_timer_stop(refresh.timer);
+    }
+    portENTER_CRITICAL(&refresh.lock);
+    bool changed = refresh.low || refresh.pclk_hz != PCLK_HZ;
+    refresh.panel = panel;
+    refresh.pclk_hz = PCLK_HZ;
+    refresh.low_pclk_hz = PCLK_IDLE_HZ;
+    refresh.idle_frames = 0;
+    refresh.low = false;
+    refresh.changes++;
+    portEXIT_CRITICAL(&refresh.lock);
+    refresh_apply(changed ? panel : NULL);
+}
+
+void st7701_activity(void) {
+    bool raise = false;
+    portENTER_CRITICAL(&refresh.lock);
+    refresh.active_frame = scanout.frame_count;
+    if (refresh.low) {
+        refresh.low = false;
+        refresh.changes++;
+        raise = true;
+    }
+    esp_lcd_panel_handle_t panel = refresh.panel;
+    portEXIT_CRITICAL(&refresh.lock);
+    if (raise) {
+        refresh_apply(panel);
+    }
+}
+
 // ============================================================================
 // RGB Panel Setup
 // ============================================================================
 
+// Everything that identifies the panel wiring, for matching a parked panel
+static void get_pins(st7701_obj_t *self, gpio_num_t *pins) {
+    pins[0] = self->spi_cs;
+    pins[1] = self->spi_clk;
+    pins[2] = self->spi_mosi;
+    pins[3] = self->reset;
+    pins[4] = self->pclk;
+    pins[5] = self->hsync;
+    pins[6] = self->vsync;
+    pins[7] = self->de;
+    for (int i = 0; i < 16; i++) {
+        pins[8 + i] = self->data[i];
+    }
+}
+
 static esp_err_t setup_rgb_panel(st7701_obj_t *self) {
-    ESP_LOGI(TAG, "Setting up RGB panel %dx%d", self->width, self->height);
+    ESP_LOGI(TAG, "Setting up RGB panel %dx%d, orientation %d", LCD_H_RES, LCD_V_RES, self->orientation);
+    
+    // The framebuffers are owned by the driver rather than esp_lcd: the panel
+    // runs without a framebuffer and pulls every line through the bounce
+    // buffers, which lets overlays be composited on the way out.
+    size_t fb_size = self->width * self->height * 2;
+    for (int i = 0; i < self->num_buffers; i++) {
+        self->buffers[i] = heap_caps_aligned_calloc(64, 1, fb_size, MALLOC_CAP_SPIRAM);
+        if (self->buffers[i] == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate %u byte framebuffer", (unsigned)fb_size);
+            heap_caps_free(self->buffers[0]);
+            self->buffers[0] = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    // Buffer 0 is shown first, so draw into the other one. A windowed
+    // display has no framebuffer at all.
+    self->back = self->num_buffers == 2 ? 1 : 0;
+    self->framebuffer = self->buffers[self->back];
+    
+    if (scanout.frame_sem == NULL) {
+        scanout.frame_sem = xSemaphoreCreateBinary();
+    }
+    scanout.width = self->width;
+    scanout.height = self->height;
+    scanout.orientation = self->orientation;
+    scanout_stats_reset();
+    scanout.front = self->buffers[0];
+    scanout.pending_front = NULL;
+    scanout.blank = false;
+    lut_reset(&scanout);
     
     esp_lcd_rgb_panel_config_t panel_config = {
         .clk_src = LCD_CLK_SRC_PLL240M,
         //.clk_src = LCD_CLK_SRC_PLL160M,
         .timings = {
-            .pclk_hz = 30000000,
-            .h_res = self->width,
-            .v_res = self->height,
+            .pclk_hz = PCLK_HZ,
+            .h_res = LCD_H_RES,
+            .v_res = LCD_V_RES,
             .hsync_pulse_width = 10,
             .hsync_back_porch = 50,
             .hsync_front_porch = 10,
@@ -297,8 +972,8 @@ static esp_err_t setup_rgb_panel(st7701_obj_t *self) {
         },
         .data_width = 16,
         .bits_per_pixel = 16,
-        .num_fbs = 1,
-        .bounce_buffer_size_px = self->width * 7,  // 480*7 divides into 480*854
+        .num_fbs = 0,
+        .bounce_buffer_size_px = LCD_H_RES * BOUNCE_LINES,
         .sram_trans_align = 8,
         .psram_trans_align = 64,
         .hsync_gpio_num = self->hsync,
@@ -313,172 +988,1608 @@ static esp_err_t setup_rgb_panel(st7701_obj_t *self) {
             self->data[12], self->data[13], self->data[14], self->data[15],
         },
         .flags = {
-            .fb_in_psram = 1,
+            .no_fb = 1,
         },
     };
     
+    esp_lcd_rgb_panel_event_callbacks_t callbacks = {
+        .on_bounce_empty = st7701_on_bounce_empty,
+    };
+    
     ESP_ERROR_CHECK(esp_lcd_new_rgb_panel(&panel_config, &self->panel_handle));
+    ESP_ERROR_CHECK(esp_lcd_rgb_panel_register_event_callbacks(self->panel_handle, &callbacks, &scanout));
     ESP_ERROR_CHECK(esp_lcd_panel_reset(self->panel_handle));
     ESP_ERROR_CHECK(esp_lcd_panel_init(self->panel_handle));
     
-    esp_lcd_rgb_panel_get_frame_buffer(self->panel_handle, 1, (void **)&self->framebuffer);
+    refresh_reset(self->panel_handle);
     
-    ESP_LOGI(TAG, "RGB panel ready, framebuffer at %p", self->framebuffer);
+    ESP_LOGI(TAG, "RGB panel ready, %d framebuffer(s) at %p", self->num_buffers, self->buffers[0]);
+    
+    persist.panel = self->panel_handle;
+    persist.buffers[0] = self->buffers[0];
+    persist.buffers[1] = self->buffers[1];
+    persist.num_buffers = self->num_buffers;
+    get_pins(self, persist.pins);
     
     return ESP_OK;
 }
 
 // ============================================================================
-// MicroPython Interface
+// Windowed Mode
 // ============================================================================
 
-// Constructor
-static mp_obj_t st7701_make_new(const mp_obj_type_t *type, size_t n_args, 
-                                  size_t n_kw, const mp_obj_t *args) {
-    mp_arg_check_num(n_args, n_kw, 10, 10, false);
-    
-    st7701_obj_t *self = m_new_obj(st7701_obj_t);
-    self->base.type = &st7701_type;
-    self->width = LCD_H_RES;
-    self->height = LCD_V_RES;
-    self->panel_handle = NULL;
-    self->framebuffer = NULL;
-    self->fb_obj = mp_const_none; 
-    
-    self->spi_cs = mp_obj_get_int(args[0]);
-    self->spi_clk = mp_obj_get_int(args[1]);
-    self->spi_mosi = mp_obj_get_int(args[2]);
-    self->reset = mp_obj_get_int(args[3]);
-    self->backlight = mp_obj_get_int(args[4]);
-    
-    self->pclk = mp_obj_get_int(args[5]);
-    self->hsync = mp_obj_get_int(args[6]);
-    self->vsync = mp_obj_get_int(args[7]);
-    self->de = mp_obj_get_int(args[8]);
-    
-    mp_obj_t *data_pins;
-    size_t data_pins_len;
-    mp_obj_get_array(args[9], &data_pins_len, &data_pins);
-    
-    if (data_pins_len != 16) {
-        mp_raise_ValueError(MP_ERROR_TEXT("data_pins must have 16 elements"));
+// Stop the scan-out reading the windows and background row, then free them
+static void windows_release(void) {
+    uint16_t *row = scanout.background_row;
+    int n = scanout.num_windows;
+    scanout.num_windows = 0;
+    scanout.background_row = NULL;
+    if (n > 0 || row != NULL) {
+        scanout_wait_frame(100);
     }
-    
-    for (int i = 0; i < 16; i++) {
-        self->data[i] = mp_obj_get_int(data_pins[i]);
+    for (int i = 0; i < n; i++) {
+        heap_caps_free(scanout.windows[i].pixels);
+        scanout.windows[i].pixels = NULL;
     }
-    
-    return MP_OBJ_FROM_PTR(self);
+    heap_caps_free(row);
 }
 
-// init()
-static mp_obj_t st7701_init(mp_obj_t self_in) {
-    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
-    
-    setup_spi_gpio(self);
-    st7701_init_sequence(self);
-    setup_rgb_panel(self);
-    setup_backlight(self, true);
-    
-    // Clear to black
-    memset(self->framebuffer, 0, self->width * self->height * 2);
+// Windows are kept in internal SRAM while that leaves this much for everything else
+#define WINDOW_SRAM_RESERVE  (64 * 1024)
+
+// Allocate the display's windows, cleared to black, and hand them to the
+// scan-out. Any previous windows are freed first.
+static esp_err_t windows_setup(st7701_obj_t *self) {
+    windows_release();
+    scanout.background = self->background;
+    
+    for (int i = 0; i < self->num_windows; i++) {
+        st7701_overlay_t *win = &scanout.windows[i];
+        size_t size = self->windows[i].w * self->windows[i].h * 2;
+        win->pixels = NULL;
+        if (heap_caps_get_free_size(MALLOC_CAP_INTERNAL) >= size + WINDOW_SRAM_RESERVE) {
+            win->pixels = heap_caps_calloc(1, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (win->pixels == NULL) {
+            win->pixels = heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM);
+        }
+        if (win->pixels == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate %u byte window", (unsigned)size);
+            for (int j = 0; j < i; j++) {
+                heap_caps_free(scanout.windows[j].pixels);
+                scanout.windows[j].pixels = NULL;
+            }
+            return ESP_ERR_NO_MEM;
+        }
+        win->x = self->windows[i].x;
+        win->y = self->windows[i].y;
+        win->w = self->windows[i].w;
+        win->h = self->windows[i].h;
+        win->format = OVERLAY_RGB565;
+        win->key = -1;
+        win->visible = true;
+        win->alpha = 32;
+    }
+    scanout.num_windows = self->num_windows;
     
-    return mp_const_none;
+    ESP_LOGI(TAG, "%d window(s)", self->num_windows);
+    return ESP_OK;
 }
-static MP_DEFINE_CONST_FUN_OBJ_1(st7701_init_obj, st7701_init);
 
-static mp_obj_t st7701_deinit(mp_obj_t self_in) {
-    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
-    
-    // Turn off backlight first
-    if (self->backlight >= 0) {
-        gpio_set_level(self->backlight, 0);
+// ============================================================================
+// Compressed Mode
+// ============================================================================
+
+// Coded rows are appended to the active arena. Replaced rows stay where they
+// are until the arena fills up, then the live rows are compacted into the
+// other arena. The scan-out reads rows through one of two pointer tables
+// while the next one is built, so it never sees a half-committed change.
+typedef struct _st7701_comp_t {
+    uint16_t *arena[2];
+    size_t size;                // words in each arena
+    size_t used;                // words appended to the active arena
+    size_t live;                // words in the rows currently in use
+    int active;                 // arena rows are appended to
+    bool compacted;             // compacted since the last publish
+    const uint16_t **tables[2]; // row pointers
+    int table;                  // table the scan-out reads
+    uint16_t *lens;             // words in each row
+    uint16_t *scratch;          // one coded row, worst case
+} st7701_comp_t;
+
+static st7701_comp_t comp;
+
+// Worst case for a coded row: every pixel a literal, plus the count
+#define COMP_ROW_MAX(w)     ((w) + 1)
+
+// Run-length code one row of n pixels, returns the number of words.
+// Runs of 3 or more pixels are coded as runs, everything else as literals.
+static size_t comp_encode_row(const uint16_t *src, int n, uint16_t *out) {
+    size_t len = 0;
+    int lit = 0;            // start of the literals not yet written
+    int i = 0;
+    while (i < n) {
+        int j = i + 1;
+        while (j < n && src[j] == src[i] && j - i < 0x7FFF) {
+            j++;
+        }
+        if (j - i >= 3) {
+            if (lit < i) {
+                out[len++] = i - lit;
+                memcpy(out + len, src + lit, (i - lit) * 2);
+                len += i - lit;
+            }
+            out[len++] = 0x8000 | (j - i);
+            out[len++] = src[i];
+            lit = j;
+        }
+        i = j;
     }
-    
-    if (self->panel_handle != NULL) {
-        esp_lcd_panel_del(self->panel_handle);
-        self->panel_handle = NULL;
-        self->framebuffer = NULL;
-        self->fb_obj = mp_const_none;  // invalidate cached memoryview
+    if (lit < n) {
+        out[len++] = n - lit;
+        memcpy(out + len, src + lit, (n - lit) * 2);
+        len += n - lit;
     }
-    
-    return mp_const_none;
+    return len;
 }
-static MP_DEFINE_CONST_FUN_OBJ_1(st7701_deinit_obj, st7701_deinit);
 
-// framebuffer() -> memoryview
-static mp_obj_t st7701_framebuffer(mp_obj_t self_in) {
-    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
-    
-    if (self->framebuffer == NULL) {
-        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+// Stop the scan-out reading the coded rows, then free them
+static void comp_release(void) {
+    const uint16_t *const *rows = scanout.rows;
+    scanout.rows = NULL;
+    scanout.pending_rows = NULL;
+    if (rows != NULL) {
+        scanout_wait_frame(100);
     }
-    
-    if (self->fb_obj == mp_const_none) {
-        size_t size = self->width * self->height * 2;
-        //return mp_obj_new_bytearray_by_ref(size, self->framebuffer);
-        self->fb_obj = mp_obj_new_memoryview('B' | 0x80, size, self->framebuffer);
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(comp.arena[i]);
+        heap_caps_free(comp.tables[i]);
     }
-    
-    return self->fb_obj;
+    heap_caps_free(comp.lens);
+    heap_caps_free(comp.scratch);
+    memset(&comp, 0, sizeof(comp));
 }
-static MP_DEFINE_CONST_FUN_OBJ_1(st7701_framebuffer_obj, st7701_framebuffer);
 
-// width()
-static mp_obj_t st7701_width(mp_obj_t self_in) {
-    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
-    return mp_obj_new_int(self->width);
+// Move the rows in table into the other arena, packed, and append there
+// from now on. The scan-out is still reading the current arena.
+static void comp_compact(const uint16_t **table, int height) {
+    uint16_t *dst = comp.arena[comp.active ^ 1];
+    size_t used = 0;
+    for (int y = 0; y < height; y++) {
+        memcpy(dst + used, table[y], comp.lens[y] * 2);
+        table[y] = dst + used;
+        used += comp.lens[y];
+    }
+    comp.active ^= 1;
+    comp.used = used;
 }
-static MP_DEFINE_CONST_FUN_OBJ_1(st7701_width_obj, st7701_width);
 
-// height()
-static mp_obj_t st7701_height(mp_obj_t self_in) {
-    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
-    return mp_obj_new_int(self->height);
+// Append a coded row to the active arena, compacting first if it is full.
+// Returns NULL if the rows in use don't leave room for it. Only one
+// compaction is allowed between publishes: a second would write into the
+// arena the scan-out's table still points at.
+static const uint16_t *comp_append(const uint16_t **table, int height, const uint16_t *row, size_t len) {
+    if (comp.used + len > comp.size) {
+        if (comp.compacted) {
+            return NULL;
+        }
+        comp_compact(table, height);
+        comp.compacted = true;
+        if (comp.used + len > comp.size) {
+            return NULL;
+        }
+    }
+    uint16_t *dst = comp.arena[comp.active] + comp.used;
+    memcpy(dst, row, len * 2);
+    comp.used += len;
+    return dst;
 }
-static MP_DEFINE_CONST_FUN_OBJ_1(st7701_height_obj, st7701_height);
 
-// backlight(on/off)
-static mp_obj_t st7701_backlight(mp_obj_t self_in, mp_obj_t on_in) {
-    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
-    
-    if (self->backlight >= 0) {
-        gpio_set_level(self->backlight, mp_obj_is_true(on_in) ? 1 : 0);
+// Show the rows in the table being built from the next frame, and wait for
+// the scan-out to switch so the other table can be built next time
+static void comp_publish(void) {
+    scanout.pending_rows = comp.tables[comp.table ^ 1];
+    if (!scanout_wait_frame(100) || scanout.pending_rows != NULL) {
+        // The scan-out isn't running - switch directly
+        scanout.rows = scanout.pending_rows;
+        scanout.pending_rows = NULL;
     }
-    
-    return mp_const_none;
+    comp.table ^= 1;
+    comp.compacted = false;
 }
-static MP_DEFINE_CONST_FUN_OBJ_2(st7701_backlight_obj, st7701_backlight);
 
-// Swap bytes in-place for big-endian RGB565 data
-static mp_obj_t st7701_swap_bytes(mp_obj_t buf_in) {
-    mp_buffer_info_t bufinfo;
-    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_RW);
+// Set up the arenas for a compressed display, every row the background
+// colour, and hand them to the scan-out
+static esp_err_t comp_setup(st7701_obj_t *self) {
+    comp_release();
+    if (self->compressed == 0) {
+        return ESP_OK;
+    }
     
-    uint16_t *buf = bufinfo.buf;
-    size_t len = bufinfo.len / 2;
+    int w = self->width;
+    int h = self->height;
+    comp.size = self->compressed / 2 / 2;
+    for (int i = 0; i < 2; i++) {
+        size_t bytes = comp.size * 2;
+        if (heap_caps_get_free_size(MALLOC_CAP_INTERNAL) >= bytes + WINDOW_SRAM_RESERVE) {
+            comp.arena[i] = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (comp.arena[i] == NULL) {
+            comp.arena[i] = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+        }
+        comp.tables[i] = heap_caps_malloc(h * sizeof(uint16_t *), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    comp.lens = heap_caps_malloc(h * sizeof(uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    comp.scratch = heap_caps_malloc(COMP_ROW_MAX(w) * 2, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (comp.arena[0] == NULL || comp.arena[1] == NULL || comp.tables[0] == NULL ||
+        comp.tables[1] == NULL || comp.lens == NULL || comp.scratch == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %u byte compressed frame", (unsigned)self->compressed);
+        comp_release();
+        return ESP_ERR_NO_MEM;
+    }
     
-    for (size_t i = 0; i < len; i++) {
-        buf[i] = __builtin_bswap16(buf[i]);
+    // Every row a single run - 2 words
+    const uint16_t row[2] = { 0x8000 | w, self->background };
+    for (int y = 0; y < h; y++) {
+        comp.tables[0][y] = comp_append(comp.tables[0], y, row, 2);
+        comp.lens[y] = 2;
     }
+    comp.live = comp.used;
+    scanout.rows = comp.tables[0];
     
-    return mp_const_none;
+    ESP_LOGI(TAG, "Compressed frame, %u bytes of rows in %s", (unsigned)comp.used * 2,
+             esp_ptr_internal(comp.arena[0]) ? "SRAM" : "PSRAM");
+    return ESP_OK;
 }
-static MP_DEFINE_CONST_FUN_OBJ_1(st7701_swap_bytes_obj, st7701_swap_bytes);
 
-// rgb565(r, g, b) - Convert RGB888 to RGB565
-static mp_obj_t st7701_rgb565(size_t n_args, const mp_obj_t *args) {
-    int r = mp_obj_get_int(args[0]) & 0xFF;
-    int g = mp_obj_get_int(args[1]) & 0xFF;
-    int b = mp_obj_get_int(args[2]) & 0xFF;
-    
-    uint16_t color = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-    return mp_obj_new_int(color);
-}
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_rgb565_obj, 3, 3, st7701_rgb565);
+// ============================================================================
+// Warm Restart
+// ============================================================================
+
+// Hide all overlays and free them once the scan-out has stopped reading them
+static void overlays_release_all(void) {
+    for (int i = 0; i < MAX_OVERLAYS; i++) {
+        scanout.overlays[i].next_visible = false;
+    }
+    scanout_wait_frame(100);
+    for (int i = 0; i < MAX_OVERLAYS; i++) {
+        overlay_release(&scanout.overlays[i]);
+    }
+}
+
+// Delete a parked panel and free its framebuffers
+static void persist_release(void) {
+    if (persist.panel == NULL) {
+        return;
+    }
+    refresh_reset(NULL);
+    esp_lcd_panel_del(persist.panel);
+    scanout.front = NULL;
+    scanout.pending_front = NULL;
+    windows_release();
+    comp_release();
+    for (int i = 0; i < MAX_OVERLAYS; i++) {
+        overlay_release(&scanout.overlays[i]);
+    }
+    heap_caps_free(persist.buffers[0]);
+    heap_caps_free(persist.buffers[1]);
+    memset(&persist, 0, sizeof(persist));
+}
+
+// Take over the parked panel and framebuffers. The scan-out sends black
+// while the buffers are cleared, unless clear is false, in which case the
+// old picture stays on screen.
+static esp_err_t warm_start(st7701_obj_t *self, bool clear) {
+    scanout.blank = clear;
+    scanout.pending_front = NULL;
+    int front = scanout.front == persist.buffers[1] && persist.buffers[1] != NULL ? 1 : 0;
+    
+    size_t fb_size = self->width * self->height * 2;
+    if (self->num_buffers < 2 && persist.buffers[1] != NULL) {
+        // Keep buffer 0 and move the picture into it if it was in buffer 1
+        if (self->num_buffers == 1 && front == 1 && !clear) {
+            memcpy(persist.buffers[0], persist.buffers[1], fb_size);
+        }
+        scanout.front = persist.buffers[0];
+        scanout_wait_frame(100);
+        heap_caps_free(persist.buffers[1]);
+        persist.buffers[1] = NULL;
+        front = 0;
+    }
+    if (self->num_buffers == 0 && persist.buffers[0] != NULL) {
+        // Windowed or compressed - give the framebuffer's PSRAM back
+        scanout.front = NULL;
+        scanout_wait_frame(100);
+        heap_caps_free(persist.buffers[0]);
+        persist.buffers[0] = NULL;
+    }
+    for (int i = 0; i < self->num_buffers; i++) {
+        if (persist.buffers[i] == NULL) {
+            persist.buffers[i] = heap_caps_aligned_calloc(64, 1, fb_size, MALLOC_CAP_SPIRAM);
+            if (persist.buffers[i] == NULL) {
+                ESP_LOGE(TAG, "Failed to allocate %u byte framebuffer", (unsigned)fb_size);
+                return ESP_ERR_NO_MEM;
+            }
+            clear = true;
+        }
+    }
+    persist.num_buffers = self->num_buffers;
+    
+    overlays_release_all();
+    lut_reset(&scanout);
+    refresh_reset(persist.panel);
+    
+    // The framebuffers are the same size in every orientation
+    scanout.width = self->width;
+    scanout.height = self->height;
+    scanout.orientation = self->orientation;
+    scanout_stats_reset();
+    
+    self->panel_handle = persist.panel;
+    self->buffers[0] = persist.buffers[0];
+    self->buffers[1] = persist.buffers[1];
+    self->back = self->num_buffers == 2 ? front ^ 1 : 0;
+    self->framebuffer = self->buffers[self->back];
+    scanout.front = self->buffers[front];
+    
+    if (clear) {
+        for (int i = 0; i < self->num_buffers; i++) {
+            memset(self->buffers[i], 0, fb_size);
+        }
+        scanout.blank = false;
+    }
+    
+    // Display on, in case deinit() turned it off
+    lcd_cmd(self, 0x29);
+    
+    ESP_LOGI(TAG, "Warm start, reusing panel and %d framebuffer(s)", self->num_buffers);
+    return ESP_OK;
+}
+
+// ============================================================================
+// MicroPython Interface
+// ============================================================================
+
+// Constructor
+// ST7701(spi_cs, spi_clk, spi_mosi, reset, backlight, pclk, hsync, vsync, de, data_pins, *,
+//        buffers=1, orientation=0, windows=None, background=0, compressed=0)
+// With orientation 90 or 270 the framebuffer is 854x480 (landscape) and is
+// rotated on its way to the panel. windows is a list of (x, y, w, h): only
+// those areas get pixels, and there is no framebuffer. compressed is a
+// number of bytes to keep the picture in as run-length coded rows instead.
+static mp_obj_t st7701_make_new(const mp_obj_type_t *type, size_t n_args, 
+                                  size_t n_kw, const mp_obj_t *all_args) {
+    enum { ARG_spi_cs, ARG_spi_clk, ARG_spi_mosi, ARG_reset, ARG_backlight,
+           ARG_pclk, ARG_hsync, ARG_vsync, ARG_de, ARG_data_pins, ARG_buffers, ARG_orientation,
+           ARG_windows, ARG_background, ARG_compressed };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_spi_cs,    MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_spi_clk,   MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_spi_mosi,  MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_reset,     MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_backlight, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_pclk,      MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_hsync,     MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_vsync,     MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_de,        MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_data_pins, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_buffers,   MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 1} },
+        { MP_QSTR_orientation, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_windows,   MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_background, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = COLOR_BLACK} },
+        { MP_QSTR_compressed, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    
+    if (args[ARG_buffers].u_int != 1 && args[ARG_buffers].u_int != 2) {
+        mp_raise_ValueError(MP_ERROR_TEXT("buffers must be 1 or 2"));
+    }
+    mp_int_t orientation = args[ARG_orientation].u_int;
+    if (orientation != 0 && orientation != 90 && orientation != 180 && orientation != 270) {
+        mp_raise_ValueError(MP_ERROR_TEXT("orientation must be 0, 90, 180 or 270"));
+    }
+    bool landscape = orientation == 90 || orientation == 270;
+    
+    // Finaliser so the panel is parked when the object goes away, which
+    // includes a soft reset
+    st7701_obj_t *self = m_new_obj_with_finaliser(st7701_obj_t);
+    self->base.type = &st7701_type;
+    self->width = landscape ? LCD_V_RES : LCD_H_RES;
+    self->height = landscape ? LCD_H_RES : LCD_V_RES;
+    self->orientation = orientation;
+    self->background = args[ARG_background].u_int;
+    self->num_windows = 0;
+    for (int i = 0; i < ST7701_MAX_WINDOWS; i++) {
+        self->win_obj[i] = mp_const_none;
+    }
+    
+    self->panel_handle = NULL;
+    self->framebuffer = NULL;
+    self->buffers[0] = self->buffers[1] = NULL;
+    self->num_buffers = args[ARG_buffers].u_int;
+    self->back = 0;
+    self->fb_obj[0] = self->fb_obj[1] = mp_const_none; 
+    self->flip_pending = false;
+    self->compressed = 0;
+    self->edit_obj = mp_const_none;
+    
+    if (args[ARG_windows].u_obj != mp_const_none) {
+        mp_obj_t *windows;
+        size_t num_windows;
+        mp_obj_get_array(args[ARG_windows].u_obj, &num_windows, &windows);
+        if (num_windows < 1 || num_windows > ST7701_MAX_WINDOWS) {
+            mp_raise_ValueError(MP_ERROR_TEXT("windows must list 1 to 4 rectangles"));
+        }
+        if (self->num_buffers == 2) {
+            mp_raise_ValueError(MP_ERROR_TEXT("windows can't be double buffered"));
+        }
+        for (size_t i = 0; i < num_windows; i++) {
+            mp_obj_t *rect;
+            mp_obj_get_array_fixed_n(windows[i], 4, &rect);
+            mp_int_t x = mp_obj_get_int(rect[0]);
+            mp_int_t y = mp_obj_get_int(rect[1]);
+            mp_int_t w = mp_obj_get_int(rect[2]);
+            mp_int_t h = mp_obj_get_int(rect[3]);
+            if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > self->width || y + h > self->height) {
+                mp_raise_ValueError(MP_ERROR_TEXT("window outside the display"));
+            }
+            self->windows[i].x = x;
+            self->windows[i].y = y;
+            self->windows[i].w = w;
+            self->windows[i].h = h;
+        }
+        self->num_windows = num_windows;
+        self->num_buffers = 0;
+    }
+    
+    if (args[ARG_compressed].u_int != 0) {
+        mp_int_t size = args[ARG_compressed].u_int;
+        // Enough for every row as a single run, in each of the two arenas
+        if (size < self->height * 2 * 2 * 2) {
+            mp_raise_ValueError(MP_ERROR_TEXT("compressed size too small"));
+        }
+        if (self->num_windows > 0 || self->num_buffers == 2) {
+            mp_raise_ValueError(MP_ERROR_TEXT("compressed can't be windowed or double buffered"));
+        }
+        if (landscape) {
+            mp_raise_ValueError(MP_ERROR_TEXT("compressed needs orientation 0 or 180"));
+        }
+        self->compressed = size;
+        self->num_buffers = 0;
+    }
+    
+    self->spi_cs = args[ARG_spi_cs].u_int;
+    self->spi_clk = args[ARG_spi_clk].u_int;
+    self->spi_mosi = args[ARG_spi_mosi].u_int;
+    self->reset = args[ARG_reset].u_int;
+    self->backlight = args[ARG_backlight].u_int;
+    
+    self->pclk = args[ARG_pclk].u_int;
+    self->hsync = args[ARG_hsync].u_int;
+    self->vsync = args[ARG_vsync].u_int;
+    self->de = args[ARG_de].u_int;
+    
+    mp_obj_t *data_pins;
+    size_t data_pins_len;
+    mp_obj_get_array(args[ARG_data_pins].u_obj, &data_pins_len, &data_pins);
+    
+    if (data_pins_len != 16) {
+        mp_raise_ValueError(MP_ERROR_TEXT("data_pins must have 16 elements"));
+    }
+    
+    for (int i = 0; i < 16; i++) {
+        self->data[i] = mp_obj_get_int(data_pins[i]);
+    }
+    
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Helper: drop an object's hold on the panel - its receivers, buffers and
+// cached memoryviews - without touching the scan-out or what is parked
+static void detach(st7701_obj_t *self) {
+    st7701_receivers_stop(self);
+    self->panel_handle = NULL;
+    for (int i = 0; i < 2; i++) {
+        self->buffers[i] = NULL;
+        self->fb_obj[i] = mp_const_none;  // invalidate cached memoryviews
+    }
+    for (int i = 0; i < ST7701_MAX_WINDOWS; i++) {
+        self->win_obj[i] = mp_const_none;
+    }
+    self->framebuffer = NULL;
+    self->flip_pending = false;
+    self->edit_obj = mp_const_none;
+}
+
+// init([clear]) -> True for a warm start
+// If a panel on the same pins was parked by deinit() or a soft reset, it is
+// reused as it is. clear=False keeps its picture on screen. Another object
+// still driving the panel is detached from it first, and its deinit()
+// then does nothing.
+static mp_obj_t st7701_init(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_init);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    bool clear = n_args > 1 ? mp_obj_is_true(args[1]) : true;
+    
+    if (persist.owner != NULL && persist.owner != self) {
+        detach(persist.owner);
+    }
+    persist.owner = self;
+    
+    gpio_num_t pins[PERSIST_PINS];
+    get_pins(self, pins);
+    bool warm = persist.panel != NULL && memcmp(pins, persist.pins, sizeof(pins)) == 0;
+    if (!warm) {
+        // Wired differently - start from scratch
+        persist_release();
+    }
+    
+    setup_spi_gpio(self);
+    esp_err_t err;
+    if (warm) {
+        err = warm_start(self, clear);
+    } else {
+        st7701_init_sequence(self);
+        err = setup_rgb_panel(self);
+        // The framebuffers are calloc'd, so they are already black
+    }
+    if (err != ESP_OK) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Framebuffer allocation failed"));
+    }
+    if (windows_setup(self) != ESP_OK) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Window allocation failed"));
+    }
+    if (comp_setup(self) != ESP_OK) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Compressed frame allocation failed"));
+    }
+    setup_backlight(self, true);
+    
+    return mp_obj_new_bool(warm);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_init_obj, 1, 2, st7701_init);
+
+// deinit([release]) - turn the display off. The panel and framebuffers are
+// kept for the next init() unless release is True. Does nothing unless
+// this object is the one driving the panel.
+static mp_obj_t st7701_deinit(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_deinit);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    bool release = n_args > 1 && mp_obj_is_true(args[1]);
+    
+    if (persist.owner != self) {
+        // Never initialised, already deinitialised, or taken over
+        return mp_const_none;
+    }
+    persist.owner = NULL;
+    
+    // Turn off backlight first
+    if (self->backlight >= 0) {
+        gpio_set_level(self->backlight, 0);
+    }
+    
+    if (self->panel_handle != NULL) {
+        // Nothing may decode into the buffers once they're parked or freed
+        st7701_receivers_stop(self);
+        
+        if (release) {
+            persist_release();
+        } else {
+            // Park: keep scanning out, but black, and switch the panel off
+            scanout.blank = true;
+            overlays_release_all();
+            windows_release();
+            comp_release();
+            lcd_cmd(self, 0x28);
+        }
+        detach(self);
+    }
+    
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_deinit_obj, 1, 2, st7701_deinit);
+
+// __del__ - park the panel if this object is still driving it, so a soft
+// reset doesn't leave the scan-out showing its picture, overlays and
+// animations until the next init()
+static mp_obj_t st7701_del(mp_obj_t self_in) {
+    return st7701_deinit(1, &self_in);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_del_obj, st7701_del);
+
+static bool flip_settle(st7701_obj_t *self);
+
+// Raise unless there is a framebuffer to draw into. A flip(wait=False) still
+// in progress is finished first, so that it's the right buffer.
+static void check_framebuffer(st7701_obj_t *self) {
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+    if (self->framebuffer == NULL) {
+        if (self->compressed) {
+            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("compressed display has no framebuffer, use edit()"));
+        }
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("windowed display has no framebuffer, use window()"));
+    }
+    flip_settle(self);
+}
+
+// framebuffer([index]) -> memoryview
+// Without an index, returns the back buffer - the one to draw into. With
+// double buffering that changes on every flip().
+static mp_obj_t st7701_framebuffer(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_framebuffer);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    
+    check_framebuffer(self);
+    
+    mp_int_t index = n_args > 1 ? mp_obj_get_int(args[1]) : self->back;
+    if (index < 0 || index >= self->num_buffers) {
+        mp_raise_ValueError(MP_ERROR_TEXT("buffer index out of range"));
+    }
+    
+    if (self->fb_obj[index] == mp_const_none) {
+        size_t size = self->width * self->height * 2;
+        //return mp_obj_new_bytearray_by_ref(size, self->framebuffer);
+        self->fb_obj[index] = mp_obj_new_memoryview('B' | 0x80, size, self->buffers[index]);
+    }
+    
+    return self->fb_obj[index];
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_framebuffer_obj, 1, 2, st7701_framebuffer);
+
+// Queue the back buffer to be shown from the next frame
+static void flip_queue(st7701_obj_t *self) {
+    while (flip_hold) {
+        vTaskDelay(1);
+    }
+    st7701_activity();
+    scanout.pending_front = self->framebuffer;
+    self->flip_pending = true;
+}
+
+// Finish a queued flip once the scan-out has switched to it, waiting for
+// that if it hasn't yet. Returns false if no frame started in time.
+static bool flip_settle(st7701_obj_t *self) {
+    if (!self->flip_pending) {
+        return true;
+    }
+    bool ok = true;
+    if (scanout.pending_front != NULL) {
+        // The ISR switches at the start of a frame, then gives frame_sem
+        ok = scanout_wait_frame(100);
+        if (scanout.pending_front != NULL) {
+            // The scan-out isn't running - switch directly
+            scanout.front = scanout.pending_front;
+            scanout.pending_front = NULL;
+        }
+    }
+    self->flip_pending = false;
+    self->back ^= 1;
+    self->framebuffer = self->buffers[self->back];
+    return ok;
+}
+
+bool st7701_flip(st7701_obj_t *self) {
+    ST7701_TRACE_SCOPE(MP_QSTR_flip);
+    flip_settle(self);      // one queued by flip(wait=False)
+    if (self->num_buffers <= 1) {
+        while (flip_hold) {
+            vTaskDelay(1);
+        }
+        st7701_activity();
+        return scanout_wait_frame(100);
+    }
+    flip_queue(self);
+    return flip_settle(self);
+}
+
+const uint16_t *st7701_front_buffer(st7701_obj_t *self) {
+    return self->num_buffers <= 1 ? self->framebuffer : self->buffers[self->back ^ 1];
+}
+
+void st7701_compose_rows(uint16_t *dst, int y, int rows) {
+    compose_map_t m = {
+        .x0 = 0,
+        .y0 = y,
+        .x1 = scanout.width,
+        .y1 = y + rows,
+        .base = -y * scanout.width,
+        .sx = 1,
+        .sy = scanout.width,
+    };
+    compose(&scanout, dst, &m, rows * scanout.width);
+}
+
+bool st7701_wait_frame(uint32_t timeout_ms) {
+    return scanout_wait_frame(timeout_ms);
+}
+
+uint32_t st7701_frame_count(void) {
+    return scanout.frame_count;
+}
+
+uint32_t st7701_frame_start_us(void) {
+    return scanout.frame_start_us;
+}
+
+void st7701_hold_flips(bool hold) {
+    flip_hold = hold;
+}
+
+static mp_obj_t frame_wait_new(st7701_obj_t *self, bool flip);
+
+// flip(wait=True) -> index of the new back buffer
+// Shows what was drawn into the back buffer at the start of the next frame.
+// The new back buffer still holds the frame before last.
+// With wait=False the flip is queued and an awaitable is returned instead:
+// `await display.flip(wait=False)` gives the new back buffer index once the
+// switch has happened, without blocking the asyncio event loop.
+static mp_obj_t st7701_flip_method(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_self, ARG_wait };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_self, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_wait, MP_ARG_BOOL, {.u_bool = true} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(args[ARG_self].u_obj);
+    
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+    
+    if (!args[ARG_wait].u_bool) {
+        ST7701_TRACE_SCOPE(MP_QSTR_flip);
+        flip_settle(self);
+        if (self->num_buffers == 2) {
+            flip_queue(self);
+        } else {
+            st7701_activity();
+        }
+        return frame_wait_new(self, self->num_buffers == 2);
+    }
+    
+    MP_THREAD_GIL_EXIT();
+    st7701_flip(self);
+    MP_THREAD_GIL_ENTER();
+    
+    return mp_obj_new_int(self->back);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(st7701_flip_obj, 1, st7701_flip_method);
+
+void st7701_get_surface(st7701_obj_t *self, st7701_surface_t *surface) {
+    check_framebuffer(self);
+    st7701_activity();
+    surface->pixels = self->framebuffer;
+    surface->width = self->width;
+    surface->height = self->height;
+    surface->stride = self->width;
+}
+
+// width()
+static mp_obj_t st7701_width(mp_obj_t self_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_width);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int(self->width);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_width_obj, st7701_width);
+
+// height()
+static mp_obj_t st7701_height(mp_obj_t self_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_height);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int(self->height);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_height_obj, st7701_height);
+
+// backlight(on/off)
+static mp_obj_t st7701_backlight(mp_obj_t self_in, mp_obj_t on_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_backlight);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    
+    if (self->backlight >= 0) {
+        gpio_set_level(self->backlight, mp_obj_is_true(on_in) ? 1 : 0);
+    }
+    
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(st7701_backlight_obj, st7701_backlight);
+
+// ============================================================================
+// Refresh Rate
+// ============================================================================
+
+static uint32_t get_pclk(mp_obj_t pclk_in) {
+    mp_int_t pclk = mp_obj_get_int(pclk_in);
+    if (pclk < PCLK_MIN_HZ || pclk > PCLK_MAX_HZ) {
+        mp_raise_ValueError(MP_ERROR_TEXT("pclk out of range"));
+    }
+    return pclk;
+}
+
+// refresh([pclk_hz]) -> pixel clock in Hz
+// Sets the pixel clock used while the picture is changing, from the next
+// frame. Returns the clock in effect now, which is the idle rate if
+// auto_refresh() has dropped it.
+static mp_obj_t st7701_refresh(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_refresh);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+    
+    if (n_args > 1) {
+        uint32_t pclk = get_pclk(args[1]);
+        portENTER_CRITICAL(&refresh.lock);
+        refresh.pclk_hz = pclk;
+        refresh.active_frame = scanout.frame_count;
+        refresh.low = false;
+        refresh.changes++;
+        portEXIT_CRITICAL(&refresh.lock);
+        refresh_apply(self->panel_handle);
+    }
+    
+    return mp_obj_new_int_from_uint(refresh.low ? refresh.low_pclk_hz : refresh.pclk_hz);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_refresh_obj, 1, 2, st7701_refresh);
+
+// auto_refresh(idle_frames[, low_pclk_hz])
+// After idle_frames frames with no native drawing, flip() or activity(), drop
+// the pixel clock to low_pclk_hz until the next one. 0 turns it off.
+static mp_obj_t st7701_auto_refresh(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_auto_refresh);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+    
+    mp_int_t idle_frames = mp_obj_get_int(args[1]);
+    if (idle_frames < 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("idle_frames must be >= 0"));
+    }
+    uint32_t low = n_args > 2 ? get_pclk(args[2]) : PCLK_IDLE_HZ;
+    
+    if (refresh.timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = refresh_idle_check,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "st7701_idle",
+        };
+        if (esp_timer_create(&timer_args, &refresh.timer) != ESP_OK) {
+            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Failed to create idle timer"));
+        }
+    }
+    
+    portENTER_CRITICAL(&refresh.lock);
+    refresh.idle_frames = idle_frames;
+    refresh.low_pclk_hz = low;
+    refresh.active_frame = scanout.frame_count;
+    bool raise = refresh.low;
+    if (raise) {
+        refresh.low = false;
+        refresh.changes++;
+    }
+    portEXIT_CRITICAL(&refresh.lock);
+    if (raise) {
+        refresh_apply(self->panel_handle);
+    }
+    
+    if (esp_timer_is_active(refresh.timer)) {
+        esp_timer_stop(refresh.timer);
+    }
+    if (idle_frames > 0) {
+        esp_timer_start_periodic(refresh.timer, IDLE_CHECK_US);
+    }
+    
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_auto_refresh_obj, 2, 3, st7701_auto_refresh);
+
+// activity()
+// Tells auto_refresh() the picture is changing. Native drawing and flip() do
+// this themselves; call it after drawing into framebuffer() from Python.
+static mp_obj_t st7701_activity_method(mp_obj_t self_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_activity);
+    st7701_activity();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_activity_obj, st7701_activity_method);
+
+// scanout_stats([reset]) -> (fills, mean_us, max_us, budget_us, overruns)
+// Bounce buffer fill times since init() or the last reset. Each fill must
+// finish within budget_us, the time the panel takes to receive the other
+// bounce buffer at the current pixel clock; overruns counts those that
+// didn't. If there are overruns, lower the pixel clock with refresh().
+static mp_obj_t st7701_scanout_stats(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_scanout_stats);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+    
+    uint32_t fills = scanout.fills;
+    uint64_t total = scanout.fill_cycles;
+    uint32_t per_us = esp_rom_get_cpu_ticks_per_us();
+    
+    mp_obj_t tuple[5] = {
+        mp_obj_new_int_from_uint(fills),
+        mp_obj_new_int_from_uint(fills ? total / fills / per_us : 0),
+        mp_obj_new_int_from_uint(scanout.fill_max / per_us),
+        mp_obj_new_int_from_uint(scanout.fill_budget / per_us),
+        mp_obj_new_int_from_uint(scanout.overruns),
+    };
+    
+    if (n_args > 1 && mp_obj_is_true(args[1])) {
+        scanout_stats_reset();
+    }
+    
+    return mp_obj_new_tuple(5, tuple);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_scanout_stats_obj, 1, 2, st7701_scanout_stats);
+
+// ============================================================================
+// Frame Sync
+// ============================================================================
+
+// Awaitable that completes at the start of the next frame. Like
+// asyncio.ThreadSafeFlag it is a pollable stream: the waiting task is parked
+// on the event loop's poller, and the panel ISR wakes the MicroPython task
+// so the poller sees the new frame straight away. Nothing is polled or
+// slept on in between.
+typedef struct _st7701_frame_wait_obj_t {
+    mp_obj_base_t base;
+    st7701_obj_t *display;
+    uint32_t frame;             // frame_count when created
+    bool flip;                  // finish a flip(wait=False) when done
+} st7701_frame_wait_obj_t;
+
+static const mp_obj_type_t st7701_frame_wait_type;
+
+static mp_obj_t frame_wait_new(st7701_obj_t *self, bool flip) {
+    st7701_frame_wait_obj_t *wait = mp_obj_malloc(st7701_frame_wait_obj_t, &st7701_frame_wait_type);
+    wait->display = self;
+    wait->frame = scanout.frame_count;
+    wait->flip = flip;
+    return MP_OBJ_FROM_PTR(wait);
+}
+
+// A frame has started since, or there won't be another
+static bool frame_wait_done(st7701_frame_wait_obj_t *self) {
+    return scanout.frame_count != self->frame || self->display->panel_handle == NULL;
+}
+
+static mp_obj_t frame_wait_iternext(mp_obj_t self_in) {
+    st7701_frame_wait_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    
+    if (frame_wait_done(self)) {
+        scanout.waiter = NULL;
+        if (self->flip) {
+            flip_settle(self->display);
+            return mp_make_stop_iteration(MP_OBJ_NEW_SMALL_INT(self->display->back));
+        }
+        return mp_make_stop_iteration(mp_obj_new_int_from_uint(scanout.frame_count));
+    }
+    
+    // Wait on the poller for this object to become readable:
+    // asyncio.core._io_queue.queue_read(self), then yield
+    scanout.waiter = xTaskGetCurrentTaskHandle();
+    mp_obj_t asyncio = mp_import_name(MP_QSTR_asyncio, mp_const_none, MP_OBJ_NEW_SMALL_INT(0));
+    mp_obj_t io_queue = mp_load_attr(mp_load_attr(asyncio, MP_QSTR_core), MP_QSTR__io_queue);
+    mp_obj_t dest[3];
+    mp_load_method(io_queue, MP_QSTR_queue_read, dest);
+    dest[2] = self_in;
+    mp_call_method_n_kw(1, 0, dest);
+    return mp_const_none;
+}
+
+static mp_uint_t frame_wait_ioctl(mp_obj_t self_in, mp_uint_t request, uintptr_t arg, int *errcode) {
+    st7701_frame_wait_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (request == MP_STREAM_POLL) {
+        return (arg & MP_STREAM_POLL_RD) && frame_wait_done(self) ? MP_STREAM_POLL_RD : 0;
+    }
+    *errcode = MP_EINVAL;
+    return MP_STREAM_ERROR;
+}
+
+static const mp_stream_p_t frame_wait_stream_p = {
+    .ioctl = frame_wait_ioctl,
+};
+
+static MP_DEFINE_CONST_OBJ_TYPE(
+    st7701_frame_wait_type,
+    MP_QSTR_FrameWait,
+    MP_TYPE_FLAG_ITER_IS_ITERNEXT,
+    iter, frame_wait_iternext,
+    protocol, &frame_wait_stream_p
+);
+
+// vsync() -> awaitable
+// `await display.vsync()` returns the frame number once the next frame has
+// started
+static mp_obj_t st7701_vsync(mp_obj_t self_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_vsync);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+    return frame_wait_new(self, false);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_vsync_obj, st7701_vsync);
+
+// frame_budget_us() -> microseconds left before the next frame starts
+// Drawing for the next frame, and its flip, must be done by then.
+static mp_obj_t st7701_frame_budget_us(mp_obj_t self_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_frame_budget_us);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+    uint32_t pclk = refresh.low ? refresh.low_pclk_hz : refresh.pclk_hz;
+    int32_t period = (uint64_t)LINE_CLOCKS * FRAME_LINES * 1000000 / pclk;
+    int32_t elapsed = (uint32_t)esp_timer_get_time() - scanout.frame_start_us;
+    int32_t left = period - elapsed;
+    if (left < 0) {
+        left = 0;
+    } else if (left > period) {
+        left = period;
+    }
+    return mp_obj_new_int(left);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_frame_budget_us_obj, st7701_frame_budget_us);
+
+// ============================================================================
+// Windows
+// ============================================================================
+
+// window(index) -> memoryview
+// The RGB565 pixels of a window, w * h, row by row. Draw into it with
+// framebuf or Canvas(display.window(i), w, h).
+static mp_obj_t st7701_window(mp_obj_t self_in, mp_obj_t index_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_window);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+    mp_int_t index = mp_obj_get_int(index_in);
+    if (index < 0 || index >= self->num_windows) {
+        mp_raise_ValueError(MP_ERROR_TEXT("window index out of range"));
+    }
+    
+    if (self->win_obj[index] == mp_const_none) {
+        size_t size = self->windows[index].w * self->windows[index].h * 2;
+        self->win_obj[index] = mp_obj_new_memoryview('B' | 0x80, size, scanout.windows[index].pixels);
+    }
+    return self->win_obj[index];
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(st7701_window_obj, st7701_window);
+
+// background(colour) or background(row)
+// What a windowed display shows outside its windows: a solid RGB565 colour,
+// or a row of width pixels repeated down the screen (e.g. a gradient)
+static mp_obj_t st7701_background(mp_obj_t self_in, mp_obj_t bg_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_background);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    
+    if (self->num_windows == 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("display is not windowed"));
+    }
+    
+    uint16_t *row = NULL;
+    if (mp_obj_is_int(bg_in)) {
+        self->background = mp_obj_get_int(bg_in);
+    } else {
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(bg_in, &bufinfo, MP_BUFFER_READ);
+        size_t size = self->width * 2;
+        if (bufinfo.len < size) {
+            mp_raise_ValueError(MP_ERROR_TEXT("row must be width pixels"));
+        }
+        row = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (row == NULL) {
+            mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Background allocation failed"));
+        }
+        memcpy(row, bufinfo.buf, size);
+    }
+    
+    uint16_t *old = scanout.background_row;
+    scanout.background = self->background;
+    scanout.background_row = row;
+    if (old != NULL) {
+        scanout_wait_frame(100);
+        heap_caps_free(old);
+    }
+    st7701_activity();
+    
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(st7701_background_obj, st7701_background);
+
+// ============================================================================
+// Compressed Frame
+// ============================================================================
+
+// edit(y, rows) -> bytearray
+// Rows [y, y + rows) of a compressed display, decoded into a new buffer
+// (width * rows RGB565) to draw into, e.g. with Canvas(buf, width, rows).
+// Nothing changes on screen until commit(). Replaces an edit not committed.
+static mp_obj_t st7701_edit(mp_obj_t self_in, mp_obj_t y_in, mp_obj_t rows_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_edit);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+    if (self->compressed == 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("display is not compressed"));
+    }
+    mp_int_t y = mp_obj_get_int(y_in);
+    mp_int_t rows = mp_obj_get_int(rows_in);
+    if (y < 0 || rows <= 0 || y + rows > self->height) {
+        mp_raise_ValueError(MP_ERROR_TEXT("rows outside the display"));
+    }
+    
+    // A new buffer on the MicroPython heap each time, so a view of an
+    // earlier one can never point at freed memory
+    size_t size = self->width * rows * 2;
+    mp_obj_t buf = mp_obj_new_bytearray_by_ref(size, m_new(uint8_t, size));
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf, &bufinfo, MP_BUFFER_WRITE);
+    
+    const uint16_t *const *table = comp.tables[comp.table];
+    uint16_t *out = bufinfo.buf;
+    for (int i = 0; i < rows; i++) {
+        comp_decode_row(table[y + i], out, 1, self->width);
+        out += self->width;
+    }
+    
+    self->edit_obj = buf;
+    self->edit_y = y;
+    self->edit_rows = rows;
+    return buf;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(st7701_edit_obj, st7701_edit);
+
+// commit() -> (rows, bytes, us)
+// Code the rows from the last edit() again and show them from the next
+// frame. Only rows that changed are stored. Returns the number of rows that
+// changed, the size of the whole coded picture and the time taken.
+static mp_obj_t st7701_commit(mp_obj_t self_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_commit);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+    if (self->edit_obj == mp_const_none) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("nothing to commit, use edit() first"));
+    }
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(self->edit_obj, &bufinfo, MP_BUFFER_READ);
+    self->edit_obj = mp_const_none;
+    
+    int64_t start = esp_timer_get_time();
+    int w = self->width;
+    int h = self->height;
+    const uint16_t **table = comp.tables[comp.table ^ 1];
+    memcpy(table, comp.tables[comp.table], h * sizeof(uint16_t *));
+    
+    const uint16_t *src = bufinfo.buf;
+    int changed = 0;
+    bool full = false;
+    for (int y = self->edit_y; y < self->edit_y + self->edit_rows; y++, src += w) {
+        size_t len = comp_encode_row(src, w, comp.scratch);
+        if (len == comp.lens[y] && memcmp(comp.scratch, table[y], len * 2) == 0) {
+            continue;
+        }
+        // The old row stays in the arena until the next compaction, and
+        // is kept by it, so the table is whole if the new one doesn't fit
+        const uint16_t *row = comp_append(table, h, comp.scratch, len);
+        if (row == NULL) {
+            full = true;
+            break;
+        }
+        table[y] = row;
+        comp.live += len - comp.lens[y];
+        comp.lens[y] = len;
+        changed++;
+    }
+    uint32_t us = esp_timer_get_time() - start;
+    
+    // Show what fitted, even if not everything did
+    comp_publish();
+    st7701_activity();
+    if (full) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("compressed frame full"));
+    }
+    
+    mp_obj_t result[3] = {
+        mp_obj_new_int(changed),
+        mp_obj_new_int_from_uint(comp.live * 2),
+        mp_obj_new_int_from_uint(us),
+    };
+    return mp_obj_new_tuple(3, result);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_commit_obj, st7701_commit);
+
+// ============================================================================
+// Overlays
+// ============================================================================
+
+static uint8_t get_level(mp_obj_t level_in) {
+    mp_int_t level = mp_obj_get_int(level_in);
+    if (level < 0 || level > 255) {
+        mp_raise_ValueError(MP_ERROR_TEXT("level must be 0-255"));
+    }
+    return level;
+}
+
+static st7701_overlay_t *get_overlay(mp_obj_t index_in) {
+    mp_int_t index = mp_obj_get_int(index_in);
+    if (index < 0 || index >= MAX_OVERLAYS) {
+        mp_raise_ValueError(MP_ERROR_TEXT("overlay index out of range"));
+    }
+    return &scanout.overlays[index];
+}
+
+// Detach an overlay from the scan-out and free its pixels
+static void overlay_detach(st7701_obj_t *self, st7701_overlay_t *ov) {
+    if (ov->pixels == NULL) {
+        return;
+    }
+    ov->next_visible = false;
+    if (self->panel_handle != NULL && ov->visible) {
+        // Wait for the next frame latch so the ISR has stopped reading it
+        scanout_wait_frame(100);
+    }
+    overlay_release(ov);
+}
+
+// overlay(index, buffer, w, h, fmt=OVERLAY_RGB565, colour=-1)
+// RGB565: colour is the transparent key (-1 = opaque)
+// A8:     colour is the RGB565 colour the mask is drawn in
+// overlay(index, None) removes the overlay
+static mp_obj_t st7701_overlay(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_overlay);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_overlay_t *ov = get_overlay(args[1]);
+    
+    if (args[2] == mp_const_none) {
+        overlay_detach(self, ov);
+        return mp_const_none;
+    }
+    
+    if (n_args < 5) {
+        mp_raise_TypeError(MP_ERROR_TEXT("overlay needs buffer, w and h"));
+    }
+    
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[2], &bufinfo, MP_BUFFER_READ);
+    
+    mp_int_t w = mp_obj_get_int(args[3]);
+    mp_int_t h = mp_obj_get_int(args[4]);
+    mp_int_t format = n_args > 5 ? mp_obj_get_int(args[5]) : OVERLAY_RGB565;
+    mp_int_t colour = n_args > 6 ? mp_obj_get_int(args[6]) : -1;
+    
+    if (w <= 0 || h <= 0 || w > self->width || h > self->height) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid overlay size"));
+    }
+    if (format != OVERLAY_RGB565 && format != OVERLAY_A8) {
+        mp_raise_ValueError(MP_ERROR_TEXT("fmt must be OVERLAY_RGB565 or OVERLAY_A8"));
+    }
+    
+    size_t size = w * h * (format == OVERLAY_A8 ? 1 : 2);
+    if (bufinfo.len < size) {
+        mp_raise_ValueError(MP_ERROR_TEXT("buffer too small for dimensions"));
+    }
+    
+    // Keep overlays in internal SRAM where possible - the ISR reads them on
+    // every line they cover
+    void *pixels = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (pixels == NULL) {
+        pixels = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    }
+    if (pixels == NULL) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Overlay allocation failed"));
+    }
+    memcpy(pixels, bufinfo.buf, size);
+    
+    // Keep position, visibility and opacity if an existing overlay is being
+    // replaced
+    bool visible = ov->pixels != NULL ? ov->next_visible : true;
+    uint8_t alpha = ov->pixels != NULL ? ov->next_alpha : 32;
+    overlay_detach(self, ov);
+    
+    ov->w = w;
+    ov->h = h;
+    ov->format = format;
+    ov->key = format == OVERLAY_A8 ? -1 : colour;
+    ov->colour = format == OVERLAY_A8 ? (uint16_t)colour : 0;
+    ov->pixels = pixels;
+    ov->next_visible = visible;
+    ov->next_alpha = alpha;
+    
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_overlay_obj, 3, 7, st7701_overlay);
+
+// overlay_move(index, x, y) - takes effect at the start of the next frame
+static mp_obj_t st7701_overlay_move(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_overlay_move);
+    st7701_overlay_t *ov = get_overlay(args[1]);
+    overlay_stop(ov, ANIM_POS);
+    ov->next_x = mp_obj_get_int(args[2]);
+    ov->next_y = mp_obj_get_int(args[3]);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_overlay_move_obj, 4, 4, st7701_overlay_move);
+
+// overlay_show(index, on)
+static mp_obj_t st7701_overlay_show(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t on_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_overlay_show);
+    st7701_overlay_t *ov = get_overlay(index_in);
+    ov->next_visible = mp_obj_is_true(on_in);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(st7701_overlay_show_obj, st7701_overlay_show);
+
+// overlay_opacity(index, level) - 0 (invisible) to 255 (opaque), from the next frame
+static mp_obj_t st7701_overlay_opacity(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t level_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_overlay_opacity);
+    st7701_overlay_t *ov = get_overlay(index_in);
+    uint8_t level = get_level(level_in);
+    overlay_stop(ov, ANIM_OPACITY);
+    ov->next_alpha = (level + 4) >> 3;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(st7701_overlay_opacity_obj, st7701_overlay_opacity);
+
+// animate(index, prop, to, duration_ms, ease=EASE_IN_OUT, *, delay_ms=0, repeat=0, yoyo=False)
+// Animate an overlay's position (ANIM_POS, to is (x, y)) or opacity
+// (ANIM_OPACITY, to is 0-255) from where it is now. The scan-out steps it
+// at the start of every frame, with no Python involved. repeat is the
+// number of extra runs (-1 forever), yoyo runs every other one backwards.
+// overlay_move() and overlay_opacity() stop it.
+static mp_obj_t st7701_animate(size_t n_args, const mp_obj_t *args, mp_map_t *kw_args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_animate);
+    st7701_overlay_t *ov = get_overlay(args[1]);
+    mp_int_t prop = mp_obj_get_int(args[2]);
+    if (prop != ANIM_POS && prop != ANIM_OPACITY) {
+        mp_raise_ValueError(MP_ERROR_TEXT("overlays animate ANIM_POS or ANIM_OPACITY"));
+    }
+    
+    // Set up in a local and swapped in under the lock, so the scan-out
+    // steps either the old tween or the whole new one
+    st7701_tween_t tw;
+    portENTER_CRITICAL(&scanout.anim_lock);
+    int32_t from[2] = { ov->next_x, ov->next_y };
+    if (prop == ANIM_OPACITY) {
+        from[0] = ov->next_alpha * 255 / 32;
+    }
+    portEXIT_CRITICAL(&scanout.anim_lock);
+    st7701_tween_parse(&tw, from, prop == ANIM_POS ? 2 : 1, n_args - 3, args + 3, kw_args);
+    if (prop == ANIM_OPACITY && (tw.to[0] < 0 || tw.to[0] > 255)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("opacity must be 0-255"));
+    }
+    tw.active = true;
+    portENTER_CRITICAL(&scanout.anim_lock);
+    scanout.overlay_tweens[ov - scanout.overlays][prop] = tw;
+    portEXIT_CRITICAL(&scanout.anim_lock);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(st7701_animate_obj, 3, st7701_animate);
+
+// animating([index]) -> number of overlay animations running, on one
+// overlay or all of them
+static mp_obj_t st7701_animating(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_animating);
+    int first = 0;
+    int last = MAX_OVERLAYS - 1;
+    if (n_args > 1) {
+        first = last = get_overlay(args[1]) - scanout.overlays;
+    }
+    int count = 0;
+    for (int i = first; i <= last; i++) {
+        for (int prop = 0; prop <= ANIM_OPACITY; prop++) {
+            count += scanout.overlay_tweens[i][prop].active;
+        }
+    }
+    return mp_obj_new_int(count);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_animating_obj, 1, 2, st7701_animating);
+
+// stop_animation(index, [prop]) - stop an overlay's animations (or just one),
+// leaving it where it got to
+static mp_obj_t st7701_stop_animation(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_stop_animation);
+    overlay_stop(get_overlay(args[1]), n_args > 2 ? mp_obj_get_int(args[2]) : -1);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_stop_animation_obj, 2, 3, st7701_stop_animation);
+
+// ============================================================================
+// Colour LUT
+// ============================================================================
+
+static void get_curve(mp_obj_t buf_in, uint8_t *curve, size_t n, uint8_t max) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_READ);
+    if (bufinfo.len < n) {
+        mp_raise_ValueError(MP_ERROR_TEXT("lut needs 32, 64 and 32 entries"));
+    }
+    memcpy(curve, bufinfo.buf, n);
+    for (size_t i = 0; i < n; i++) {
+        if (curve[i] > max) {
+            mp_raise_ValueError(max == 63 ? MP_ERROR_TEXT("g curve values must be 0-63")
+                                          : MP_ERROR_TEXT("r and b curve values must be 0-31"));
+        }
+    }
+}
+
+// lut(r, g, b) - per-channel curves of 32, 64 and 32 entries in channel units
+// lut(None)    - back to the identity curve
+static mp_obj_t st7701_lut(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_lut);
+    if (args[1] == mp_const_none) {
+        scanout.curve_identity = true;
+    } else {
+        if (n_args != 4) {
+            mp_raise_TypeError(MP_ERROR_TEXT("lut needs r, g and b curves"));
+        }
+        // Check all three before touching the live curves
+        uint8_t r[32], g[64], b[32];
+        get_curve(args[1], r, 32, 31);
+        get_curve(args[2], g, 64, 63);
+        get_curve(args[3], b, 32, 31);
+        memcpy(scanout.curve_r, r, sizeof(r));
+        memcpy(scanout.curve_g, g, sizeof(g));
+        memcpy(scanout.curve_b, b, sizeof(b));
+        scanout.curve_identity = false;
+    }
+    scanout.lut_dirty = true;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_lut_obj, 2, 4, st7701_lut);
+
+// brightness(level) - software brightness, 0-255
+static mp_obj_t st7701_brightness(mp_obj_t self_in, mp_obj_t level_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_brightness);
+    scanout.brightness = get_level(level_in);
+    scanout.lut_dirty = true;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(st7701_brightness_obj, st7701_brightness);
+
+// tint(r, g, b) - per-channel gain, 0-255 (e.g. tint(255, 170, 110) for night mode)
+static mp_obj_t st7701_tint(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_tint);
+    scanout.gain_r = get_level(args[1]);
+    scanout.gain_g = get_level(args[2]);
+    scanout.gain_b = get_level(args[3]);
+    scanout.lut_dirty = true;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_tint_obj, 4, 4, st7701_tint);
+
+// fade()                -> current fade level
+// fade(level, [frames]) - animate the fade level to 0-255 over a number of frames
+static mp_obj_t st7701_fade(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_fade);
+    if (n_args == 1) {
+        return mp_obj_new_int(scanout.fade >> 16);
+    }
+    
+    int32_t target = (int32_t)get_level(args[1]) << 16;
+    mp_int_t frames = n_args > 2 ? mp_obj_get_int(args[2]) : 0;
+    
+    // Stop any running fade before touching its state
+    scanout.fade_frames = 0;
+    if (frames <= 0) {
+        scanout.fade = target;
+        scanout.lut_dirty = true;
+    } else {
+        scanout.fade_step = (target - (int32_t)scanout.fade) / frames;
+        // Land exactly on the target on the last frame
+        scanout.fade = target - scanout.fade_step * frames;
+        scanout.fade_frames = frames;
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_fade_obj, 1, 3, st7701_fade);
+
+// panel_gamma(positive, negative) - reprogram the panel gamma registers (0xB0/0xB1)
+// with 16 bytes each, in the same layout as st7701_init_sequence()
+static mp_obj_t st7701_panel_gamma(mp_obj_t self_in, mp_obj_t pos_in, mp_obj_t neg_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_panel_gamma);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    
+    mp_buffer_info_t pos, neg;
+    mp_get_buffer_raise(pos_in, &pos, MP_BUFFER_READ);
+    mp_get_buffer_raise(neg_in, &neg, MP_BUFFER_READ);
+    if (pos.len != 16 || neg.len != 16) {
+        mp_raise_ValueError(MP_ERROR_TEXT("gamma tables must be 16 bytes"));
+    }
+    
+    // Page 10 (display settings)
+    lcd_cmd(self, 0xFF);
+    lcd_data(self, 0x77); lcd_data(self, 0x01); lcd_data(self, 0x00);
+    lcd_data(self, 0x00); lcd_data(self, 0x10);
+    
+    lcd_cmd(self, 0xB0);
+    for (int i = 0; i < 16; i++) {
+        lcd_data(self, ((const uint8_t *)pos.buf)[i]);
+    }
+    lcd_cmd(self, 0xB1);
+    for (int i = 0; i < 16; i++) {
+        lcd_data(self, ((const uint8_t *)neg.buf)[i]);
+    }
+    
+    // Back to the standard command page
+    lcd_cmd(self, 0xFF);
+    lcd_data(self, 0x77); lcd_data(self, 0x01); lcd_data(self, 0x00);
+    lcd_data(self, 0x00); lcd_data(self, 0x00);
+    
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(st7701_panel_gamma_obj, st7701_panel_gamma);
+
+// Swap bytes in-place for big-endian RGB565 data
+static mp_obj_t st7701_swap_bytes(mp_obj_t buf_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_swap_bytes);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_RW);
+    
+    uint16_t *buf = bufinfo.buf;
+    size_t len = bufinfo.len / 2;
+    
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = __builtin_bswap16(buf[i]);
+    }
+    
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_swap_bytes_obj, st7701_swap_bytes);
+
+// rgb565(r, g, b) - Convert RGB888 to RGB565
+static mp_obj_t st7701_rgb565(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_rgb565);
+    int r = mp_obj_get_int(args[0]) & 0xFF;
+    int g = mp_obj_get_int(args[1]) & 0xFF;
+    int b = mp_obj_get_int(args[2]) & 0xFF;
+    
+    uint16_t color = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    return mp_obj_new_int(color);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_rgb565_obj, 3, 3, st7701_rgb565);
+
+#define FLIP_MIN_CHUNK      32          // pixels, below this swap one at a time
+
+// Helper: Vertical flip. Rows are swapped through a staging buffer in the
+// scratch arena, a row (or as much of one as fits) at a time.
+static void flip_vertical(uint16_t *buffer, int w, int h) {
+    size_t mark = st7701_scratch_mark();
+    size_t got;
+    uint16_t *tmp = st7701_scratch_alloc(w * sizeof(uint16_t), FLIP_MIN_CHUNK * sizeof(uint16_t), &got);
+    if (tmp != NULL) {
+        int chunk = got / sizeof(uint16_t);
+        for (int y = 0; y < h / 2; y++) {
+            uint16_t *top = buffer + y * w;
+            uint16_t *bottom = buffer + (h - 1 - y) * w;
+            for (int x = 0; x < w; x += chunk) {
+                size_t n = (w - x < chunk ? w - x : chunk) * sizeof(uint16_t);
+                memcpy(tmp, top + x, n);
+                memcpy(top + x, bottom + x, n);
+                memcpy(bottom + x, tmp, n);
+            }
+        }
+        st7701_scratch_release(mark);
+        return;
+    }
 
-// Helper: Vertical flip
-static void flip_vertical(uint16_t *buffer, int w, int h) {
     for (int y = 0; y < h / 2; y++) {
         for (int x = 0; x < w; x++) {
             uint16_t temp = buffer[y * w + x];
@@ -521,9 +2632,120 @@ static void transpose_rectangular(uint16_t *buffer, int w, int h) {
     }
 }
 
-// Rotate in-place by 90, 180, or 270 degrees - avoids any new memory allocation at the expense of more complexity
+// Scratch needed to rotate a w x h image in bands of r rows: one band, and
+// a bit per band row for the interleave
+static size_t rotate_band_bytes(int w, int h, int r) {
+    return r * w * sizeof(uint16_t) + ((size_t)w * (h / r) + 31) / 32 * 4;
+}
+
+// Helper: 90 or 270 degree rotation in bands of r rows (r divides h), for
+// images too big to stage whole. Each band is rotated within its own
+// memory, through mem, into a w high, r wide block. The blocks then hold
+// the result's rows in pieces, r pixels each, which are moved into place by
+// following the cycles of the permutation, a piece at a time.
+static void rotate_banded(uint16_t *buffer, int w, int h, int r, bool clockwise, uint8_t *mem) {
+    int k = h / r;                          // bands
+    size_t band = (size_t)r * w;
+    uint16_t *src = (uint16_t *)mem;
+    for (int i = 0; i < k; i++) {
+        uint16_t *out = buffer + i * band;
+        memcpy(src, out, band * sizeof(uint16_t));
+        for (int y = 0; y < w; y++) {
+            for (int x = 0; x < r; x++) {
+                *out++ = clockwise ? src[(r - 1 - x) * w + y] : src[x * w + w - 1 - y];
+            }
+        }
+    }
+
+    // Piece y of block i is row y of the result at column chunk i, counted
+    // from the right when clockwise. The band is free for two pieces now.
+    int n = k * w;
+    size_t piece = r * sizeof(uint16_t);
+    uint16_t *carry = src;
+    uint16_t *spare = src + r;
+    uint32_t *done = (uint32_t *)(mem + band * sizeof(uint16_t));
+    memset(done, 0, (n + 31) / 32 * 4);
+    for (int start = 0; start < n; start++) {
+        if ((done[start >> 5] >> (start & 31)) & 1) {
+            continue;
+        }
+        memcpy(carry, buffer + start * r, piece);
+        int cur = start;
+        do {
+            int i = cur / w;
+            int y = cur % w;
+            int next = y * k + (clockwise ? k - 1 - i : i);
+            memcpy(spare, buffer + next * r, piece);
+            memcpy(buffer + next * r, carry, piece);
+            uint16_t *t = carry;
+            carry = spare;
+            spare = t;
+            done[next >> 5] |= 1u << (next & 31);
+            cur = next;
+        } while (cur != start);
+    }
+}
+
+// Helper: 90 or 270 degree rotation through the scratch arena. The whole
+// image is staged if it fits, and written back rotated a row at a time;
+// otherwise it is rotated in the largest bands of rows that fit. Returns
+// false, having done nothing, if not even the smallest band fits.
+static bool rotate_staged(uint16_t *buffer, int w, int h, bool clockwise) {
+    size_t size = w * h * sizeof(uint16_t);
+    int least = 2;                          // smallest band there could be
+    while (least < h && h % least != 0) {
+        least++;
+    }
+    size_t min = least < h ? rotate_band_bytes(w, h, least) : size;
+    size_t mark = st7701_scratch_mark();
+    size_t got;
+    uint8_t *mem = st7701_scratch_alloc(size, min < size ? min : size, &got);
+    if (mem == NULL) {
+        return false;
+    }
+
+    if (got < size) {
+        // Largest band that fits, the bigger the fewer pieces to move
+        int r = h / least;
+        while (h % r != 0 || rotate_band_bytes(w, h, r) > got) {
+            r--;
+        }
+        rotate_banded(buffer, w, h, r, clockwise, mem);
+        st7701_scratch_release(mark);
+        return true;
+    }
+
+    uint16_t *src = (uint16_t *)mem;
+    memcpy(src, buffer, size);
+
+    // The result is h wide and w high. Clockwise, its row y is source
+    // column y read from the bottom up; anticlockwise, source column
+    // w - 1 - y read from the top down.
+    uint16_t *out = buffer;
+    for (int y = 0; y < w; y++) {
+        if (clockwise) {
+            const uint16_t *p = src + (h - 1) * w + y;
+            for (int x = 0; x < h; x++, p -= w) {
+                *out++ = *p;
+            }
+        } else {
+            const uint16_t *p = src + w - 1 - y;
+            for (int x = 0; x < h; x++, p += w) {
+                *out++ = *p;
+            }
+        }
+    }
+    st7701_scratch_release(mark);
+    return true;
+}
+
+// Rotate in-place by 90, 180, or 270 degrees. 90 and 270 go through the
+// scratch arena, whole or in bands of rows. Only without room for the
+// smallest band, or with a prime height that won't band, are they done
+// without any extra memory at the expense of more complexity.
 // rotate(buffer, width, height, degrees) -> (buffer, new_width, new_height)
 static mp_obj_t st7701_rotate(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_rotate);
     mp_buffer_info_t bufinfo;
     mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_RW);
     
@@ -555,6 +2777,10 @@ static mp_obj_t st7701_rotate(size_t n_args, const mp_obj_t *args) {
         new_w = w;
         new_h = h;
     } 
+    else if (rotate_staged(buffer, w, h, degrees == 90)) {
+        new_w = h;
+        new_h = w;
+    }
     else if (degrees == 90) {
         // 90 CW = Vertical flip -> Transpose
         flip_vertical(buffer, w, h);
@@ -586,10 +2812,37 @@ static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_rotate_obj, 4, 4, st7701_rotat
 static const mp_rom_map_elem_t st7701_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_init),        MP_ROM_PTR(&st7701_init_obj) },
     { MP_ROM_QSTR(MP_QSTR_deinit),      MP_ROM_PTR(&st7701_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__),     MP_ROM_PTR(&st7701_del_obj) },
     { MP_ROM_QSTR(MP_QSTR_framebuffer), MP_ROM_PTR(&st7701_framebuffer_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flip),        MP_ROM_PTR(&st7701_flip_obj) },
+    { MP_ROM_QSTR(MP_QSTR_vsync),       MP_ROM_PTR(&st7701_vsync_obj) },
+    { MP_ROM_QSTR(MP_QSTR_frame_budget_us), MP_ROM_PTR(&st7701_frame_budget_us_obj) },
+    { MP_ROM_QSTR(MP_QSTR_window),      MP_ROM_PTR(&st7701_window_obj) },
+    { MP_ROM_QSTR(MP_QSTR_background),  MP_ROM_PTR(&st7701_background_obj) },
+    { MP_ROM_QSTR(MP_QSTR_edit),        MP_ROM_PTR(&st7701_edit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_commit),      MP_ROM_PTR(&st7701_commit_obj) },
     { MP_ROM_QSTR(MP_QSTR_width),       MP_ROM_PTR(&st7701_width_obj) },
     { MP_ROM_QSTR(MP_QSTR_height),      MP_ROM_PTR(&st7701_height_obj) },
     { MP_ROM_QSTR(MP_QSTR_backlight),   MP_ROM_PTR(&st7701_backlight_obj) },
+    { MP_ROM_QSTR(MP_QSTR_refresh),     MP_ROM_PTR(&st7701_refresh_obj) },
+    { MP_ROM_QSTR(MP_QSTR_auto_refresh), MP_ROM_PTR(&st7701_auto_refresh_obj) },
+    { MP_ROM_QSTR(MP_QSTR_activity),    MP_ROM_PTR(&st7701_activity_obj) },
+    { MP_ROM_QSTR(MP_QSTR_scanout_stats), MP_ROM_PTR(&st7701_scanout_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_overlay),     MP_ROM_PTR(&st7701_overlay_obj) },
+    { MP_ROM_QSTR(MP_QSTR_overlay_move), MP_ROM_PTR(&st7701_overlay_move_obj) },
+    { MP_ROM_QSTR(MP_QSTR_overlay_show), MP_ROM_PTR(&st7701_overlay_show_obj) },
+    { MP_ROM_QSTR(MP_QSTR_overlay_opacity), MP_ROM_PTR(&st7701_overlay_opacity_obj) },
+    { MP_ROM_QSTR(MP_QSTR_animate),     MP_ROM_PTR(&st7701_animate_obj) },
+    { MP_ROM_QSTR(MP_QSTR_animating),   MP_ROM_PTR(&st7701_animating_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop_animation), MP_ROM_PTR(&st7701_stop_animation_obj) },
+    { MP_ROM_QSTR(MP_QSTR_lut),         MP_ROM_PTR(&st7701_lut_obj) },
+    { MP_ROM_QSTR(MP_QSTR_brightness),  MP_ROM_PTR(&st7701_brightness_obj) },
+    { MP_ROM_QSTR(MP_QSTR_tint),        MP_ROM_PTR(&st7701_tint_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fade),        MP_ROM_PTR(&st7701_fade_obj) },
+    { MP_ROM_QSTR(MP_QSTR_panel_gamma), MP_ROM_PTR(&st7701_panel_gamma_obj) },
+    { MP_ROM_QSTR(MP_QSTR_draw_text),   MP_ROM_PTR(&st7701_draw_text_obj) },
+    { MP_ROM_QSTR(MP_QSTR_capture),     MP_ROM_PTR(&st7701_capture_obj) },
+    { MP_ROM_QSTR(MP_QSTR_transition),  MP_ROM_PTR(&st7701_transition_obj) },
 };
 static MP_DEFINE_CONST_DICT(st7701_locals_dict, st7701_locals_dict_table);
 
@@ -604,9 +2857,20 @@ MP_DEFINE_CONST_OBJ_TYPE(
 static const mp_rom_map_elem_t st7701_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_st7701) },
     { MP_ROM_QSTR(MP_QSTR_ST7701),      MP_ROM_PTR(&st7701_type) },
+    { MP_ROM_QSTR(MP_QSTR_Font),        MP_ROM_PTR(&st7701_font_type) },
+    { MP_ROM_QSTR(MP_QSTR_Scene),       MP_ROM_PTR(&st7701_scene_type) },
+    { MP_ROM_QSTR(MP_QSTR_Canvas),      MP_ROM_PTR(&st7701_canvas_type) },
+    { MP_ROM_QSTR(MP_QSTR_StreamReceiver), MP_ROM_PTR(&st7701_stream_receiver_type) },
+    { MP_ROM_QSTR(MP_QSTR_AssetCache),  MP_ROM_PTR(&st7701_asset_cache_type) },
     { MP_ROM_QSTR(MP_QSTR_swap_bytes),  MP_ROM_PTR(&st7701_swap_bytes_obj) },
     { MP_ROM_QSTR(MP_QSTR_rgb565),      MP_ROM_PTR(&st7701_rgb565_obj) },
     { MP_ROM_QSTR(MP_QSTR_rotate),      MP_ROM_PTR(&st7701_rotate_obj) },
+    { MP_ROM_QSTR(MP_QSTR_scratch),     MP_ROM_PTR(&st7701_scratch_obj) },
+    { MP_ROM_QSTR(MP_QSTR_scratch_stats), MP_ROM_PTR(&st7701_scratch_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_trace_begin), MP_ROM_PTR(&st7701_trace_begin_obj) },
+    { MP_ROM_QSTR(MP_QSTR_trace_end),   MP_ROM_PTR(&st7701_trace_end_obj) },
+    { MP_ROM_QSTR(MP_QSTR_trace_mark),  MP_ROM_PTR(&st7701_trace_mark_obj) },
+    { MP_ROM_QSTR(MP_QSTR_trace_dump),  MP_ROM_PTR(&st7701_trace_dump_obj) },
 
     // Module-level color constants
     { MP_ROM_QSTR(MP_QSTR_BLACK),       MP_ROM_INT(COLOR_BLACK) },
@@ -614,6 +2878,35 @@ static const mp_rom_map_elem_t st7701_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_RED),         MP_ROM_INT(COLOR_RED) },
     { MP_ROM_QSTR(MP_QSTR_GREEN),       MP_ROM_INT(COLOR_GREEN) },
     { MP_ROM_QSTR(MP_QSTR_BLUE),        MP_ROM_INT(COLOR_BLUE) },
+
+    // Overlay formats
+    { MP_ROM_QSTR(MP_QSTR_OVERLAY_RGB565), MP_ROM_INT(OVERLAY_RGB565) },
+    { MP_ROM_QSTR(MP_QSTR_OVERLAY_A8),     MP_ROM_INT(OVERLAY_A8) },
+
+    // Capture formats
+    { MP_ROM_QSTR(MP_QSTR_CAPTURE_RAW),    MP_ROM_INT(CAPTURE_RAW) },
+    { MP_ROM_QSTR(MP_QSTR_CAPTURE_RLE),    MP_ROM_INT(CAPTURE_RLE) },
+    { MP_ROM_QSTR(MP_QSTR_CAPTURE_QOI),    MP_ROM_INT(CAPTURE_QOI) },
+
+    // Transition kinds and directions
+    { MP_ROM_QSTR(MP_QSTR_TRANSITION_SLIDE),     MP_ROM_INT(TRANSITION_SLIDE) },
+    { MP_ROM_QSTR(MP_QSTR_TRANSITION_WIPE),      MP_ROM_INT(TRANSITION_WIPE) },
+    { MP_ROM_QSTR(MP_QSTR_TRANSITION_CROSSFADE), MP_ROM_INT(TRANSITION_CROSSFADE) },
+    { MP_ROM_QSTR(MP_QSTR_TRANSITION_PUSH),      MP_ROM_INT(TRANSITION_PUSH) },
+    { MP_ROM_QSTR(MP_QSTR_TRANSITION_LEFT),      MP_ROM_INT(TRANSITION_LEFT) },
+    { MP_ROM_QSTR(MP_QSTR_TRANSITION_RIGHT),     MP_ROM_INT(TRANSITION_RIGHT) },
+    { MP_ROM_QSTR(MP_QSTR_TRANSITION_UP),        MP_ROM_INT(TRANSITION_UP) },
+    { MP_ROM_QSTR(MP_QSTR_TRANSITION_DOWN),      MP_ROM_INT(TRANSITION_DOWN) },
+
+    // Animation easing curves and properties
+    { MP_ROM_QSTR(MP_QSTR_EASE_LINEAR),     MP_ROM_INT(EASE_LINEAR) },
+    { MP_ROM_QSTR(MP_QSTR_EASE_IN),         MP_ROM_INT(EASE_IN) },
+    { MP_ROM_QSTR(MP_QSTR_EASE_OUT),        MP_ROM_INT(EASE_OUT) },
+    { MP_ROM_QSTR(MP_QSTR_EASE_IN_OUT),     MP_ROM_INT(EASE_IN_OUT) },
+    { MP_ROM_QSTR(MP_QSTR_EASE_OUT_BACK),   MP_ROM_INT(EASE_OUT_BACK) },
+    { MP_ROM_QSTR(MP_QSTR_ANIM_POS),        MP_ROM_INT(ANIM_POS) },
+    { MP_ROM_QSTR(MP_QSTR_ANIM_OPACITY),    MP_ROM_INT(ANIM_OPACITY) },
+    { MP_ROM_QSTR(MP_QSTR_ANIM_SCROLL),     MP_ROM_INT(ANIM_SCROLL) },
 };
 static MP_DEFINE_CONST_DICT(st7701_module_globals, st7701_module_globals_table);
 
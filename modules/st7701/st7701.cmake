@@ -1,7 +1,19 @@
 add_library(usermod_st7701 INTERFACE)
 
 target_sources(usermod_st7701 INTERFACE
-    ${CMAKE_CURRENT_LIST_DIR}/st7701.c)
+    ${CMAKE_CURRENT_LIST_DIR}/st7701.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_text.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_scene.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_canvas.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_capture.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_stream.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_receiver.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_trace.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_assets.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_transition.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_shapes.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_scratch.c
+    ${CMAKE_CURRENT_LIST_DIR}/st7701_anim.c)
 
 target_include_directories(usermod_st7701 INTERFACE
     ${CMAKE_CURRENT_LIST_DIR}
@@ -9,4 +21,7 @@ target_include_directories(usermod_st7701 INTERFACE
     $ENV{IDF_PATH}/components/esp_lcd/rgb/include
 )
 
+# Tracing is compiled in but idle until trace_begin(). To remove it entirely:
+# target_compile_definitions(usermod_st7701 INTERFACE ST7701_TRACE=0)
+
 target_link_libraries(usermod INTERFACE usermod_st7701)
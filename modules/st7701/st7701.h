@@ -0,0 +1,417 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - shared definitions
+ *
+ * The display object lives in st7701.c; drawing engines in the other
+ * st7701_*.c files work on plain RGB565 surfaces described here.
+ */
+
+#ifndef ST7701_H
+#define ST7701_H
+
+#include "py/obj.h"
+
+#include "esp_lcd_panel_rgb.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+
+// ============================================================================
+// ST7701 Display Object
+// ============================================================================
+
+#define ST7701_MAX_WINDOWS  4
+
+typedef struct _st7701_obj_t {
+    mp_obj_base_t base;
+    esp_lcd_panel_handle_t panel_handle;
+    uint16_t *framebuffer;      // buffer to draw into (the back buffer), NULL if windowed or compressed
+    uint16_t *buffers[2];
+    uint8_t num_buffers;        // 1, 2 for double buffering, 0 if windowed or compressed
+    uint8_t back;               // index of the back buffer in buffers[]
+    bool flip_pending;          // flip(wait=False) queued, back not switched yet
+    uint16_t width;             // framebuffer size - 854x480 in landscape orientations
+    uint16_t height;
+    uint16_t orientation;       // 0, 90, 180 or 270, applied at scan-out
+    
+    // SPI pins for init
+    gpio_num_t spi_cs;
+    gpio_num_t spi_clk;
+    gpio_num_t spi_mosi;
+    gpio_num_t reset;
+    gpio_num_t backlight;
+    
+    // RGB pins
+    gpio_num_t pclk;
+    gpio_num_t hsync;
+    gpio_num_t vsync;
+    gpio_num_t de;
+    gpio_num_t data[16];
+
+    // Cached framebuffer memoryviews, one per buffer
+    mp_obj_t fb_obj[2];
+    
+    // Windowed mode: only these areas have pixels, the scan-out fills in
+    // the rest from the background
+    uint8_t num_windows;
+    struct {
+        int16_t x;
+        int16_t y;
+        uint16_t w;
+        uint16_t h;
+    } windows[ST7701_MAX_WINDOWS];
+    uint16_t background;
+    mp_obj_t win_obj[ST7701_MAX_WINDOWS];
+    
+    // Compressed mode: the picture is kept as run-length coded rows, and
+    // changed a band of rows at a time with edit() and commit()
+    uint32_t compressed;        // bytes for the coded rows, 0 if not compressed
+    mp_obj_t edit_obj;          // buffer from edit(), mp_const_none if none
+    int16_t edit_y;
+    uint16_t edit_rows;
+} st7701_obj_t;
+
+extern const mp_obj_type_t st7701_type;
+
+// Show the back buffer at the start of the next frame and make the other
+// buffer the back buffer. Blocks until the scan-out has switched. With a
+// single buffer this just waits for the next frame. Safe to call from any
+// task; returns false on timeout.
+bool st7701_flip(st7701_obj_t *self);
+
+// Buffer currently being scanned out
+const uint16_t *st7701_front_buffer(st7701_obj_t *self);
+
+// Compose whole framebuffer rows [y, y + rows) as they are sent to the
+// panel, with overlays and the colour LUT applied (before rotation)
+void st7701_compose_rows(uint16_t *dst, int y, int rows);
+
+// Block until the scan-out starts a new frame; false on timeout
+bool st7701_wait_frame(uint32_t timeout_ms);
+
+// Frames started since init()
+uint32_t st7701_frame_count(void);
+
+// esp_timer time the current frame started, in microseconds (wraps)
+uint32_t st7701_frame_start_us(void);
+
+// While held, st7701_flip() waits instead of changing the front buffer
+void st7701_hold_flips(bool hold);
+
+// Note that the picture is changing, so auto_refresh() restores the full
+// pixel clock. Called by st7701_get_surface() and st7701_flip().
+void st7701_activity(void);
+
+// ============================================================================
+// Drawing Surfaces
+// ============================================================================
+
+// An RGB565 pixel buffer. stride is in pixels.
+typedef struct _st7701_surface_t {
+    uint16_t *pixels;
+    int width;
+    int height;
+    int stride;
+} st7701_surface_t;
+
+// Clip rectangle, half-open: x0 <= x < x1, y0 <= y < y1
+typedef struct _st7701_rect_t {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+} st7701_rect_t;
+
+// Surface for the display framebuffer - raises if not initialised
+void st7701_get_surface(st7701_obj_t *self, st7701_surface_t *surface);
+
+// Intersect a clip rectangle with the surface bounds
+static inline void st7701_clip_to_surface(st7701_rect_t *clip, const st7701_surface_t *surface) {
+    if (clip->x0 < 0) clip->x0 = 0;
+    if (clip->y0 < 0) clip->y0 = 0;
+    if (clip->x1 > surface->width) clip->x1 = surface->width;
+    if (clip->y1 > surface->height) clip->y1 = surface->height;
+}
+
+// Set n pixels to a colour
+static inline void st7701_fill_span(uint16_t *p, int n, uint16_t colour) {
+    // Align to 32 bits, then write two pixels at a time
+    if (((uintptr_t)p & 2) && n > 0) {
+        *p++ = colour;
+        n--;
+    }
+    uint32_t c2 = colour | ((uint32_t)colour << 16);
+    uint32_t *p32 = (uint32_t *)p;
+    for (int i = n >> 1; i > 0; i--) {
+        *p32++ = c2;
+    }
+    if (n & 1) {
+        *(uint16_t *)p32 = colour;
+    }
+}
+
+// Blend two RGB565 colours, alpha 0..32
+static inline uint16_t IRAM_ATTR blend565(uint16_t fg, uint16_t bg, uint32_t alpha) {
+    uint32_t f = (fg | ((uint32_t)fg << 16)) & 0x07E0F81F;
+    uint32_t b = (bg | ((uint32_t)bg << 16)) & 0x07E0F81F;
+    b += ((f - b) * alpha) >> 5;
+    b &= 0x07E0F81F;
+    return (uint16_t)((b >> 16) | b);
+}
+
+// Where pixel (x, y) of a w x h image rotated clockwise by degrees (0, 90,
+// 180 or 270) comes from: src[base + x * dx + y * dy]
+static inline void st7701_rotation_steps(int degrees, int w, int h, int *base, int *dx, int *dy) {
+    switch (degrees) {
+        case 90:  *base = (h - 1) * w; *dx = -w; *dy = 1;  break;
+        case 180: *base = h * w - 1;   *dx = -1; *dy = -w; break;
+        case 270: *base = w - 1;       *dx = w;  *dy = -1; break;
+        default:  *base = 0;           *dx = 1;  *dy = w;  break;
+    }
+}
+
+// ============================================================================
+// Text (st7701_text.c)
+// ============================================================================
+
+extern const mp_obj_type_t st7701_font_type;
+
+// Draw UTF-8 text with its line box top-left at (x, y). bg < 0 blends onto
+// the existing pixels. Returns the pen x position after the last glyph.
+int st7701_text_draw(const st7701_surface_t *surface, const st7701_rect_t *clip, mp_obj_t font_in,
+                     const char *str, size_t len, int x, int y, uint16_t colour, int32_t bg);
+
+MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_draw_text_obj);
+
+// ============================================================================
+// Tile layer and sprites (st7701_scene.c)
+// ============================================================================
+
+extern const mp_obj_type_t st7701_scene_type;
+
+// ============================================================================
+// Canvas (st7701_canvas.c)
+// ============================================================================
+
+#define CANVAS_CLIP_DEPTH   8
+
+// Buffer selection for a canvas on the display
+#define CANVAS_BACK         -1      // follows the back buffer across flips
+#define CANVAS_FRONT        -2      // the buffer on screen
+
+typedef struct _st7701_canvas_obj_t {
+    mp_obj_base_t base;
+    mp_obj_t target;            // ST7701 display, or the offscreen buffer object
+    int which;                  // CANVAS_BACK, CANVAS_FRONT or a buffer index
+    uint16_t *pixels;           // offscreen pixels, NULL on the display
+    int width;
+    int height;
+
+    // Origin and clip (in surface coordinates) in effect, and the saved ones
+    int ox;
+    int oy;
+    st7701_rect_t clip;
+    uint8_t depth;
+    struct {
+        int ox;
+        int oy;
+        st7701_rect_t clip;
+    } stack[CANVAS_CLIP_DEPTH];
+
+    // Cached 'H' memoryview and the pixels it was made for
+    mp_obj_t view_obj;
+    uint16_t *view_pixels;
+} st7701_canvas_obj_t;
+
+extern const mp_obj_type_t st7701_canvas_type;
+
+// Surface a canvas currently draws into - raises if the display isn't initialised
+void st7701_canvas_surface(st7701_canvas_obj_t *self, st7701_surface_t *surface);
+
+// ============================================================================
+// Anti-aliased shapes (st7701_shapes.c)
+// ============================================================================
+
+// Draw a shape in surface coordinates, clipped, blending its edges into the
+// pixels under them. A width of 0 fills the shape, otherwise only a stroke
+// that thick is drawn, on the inside of the outline. Arc angles are degrees
+// clockwise from 12 o'clock. Each returns the number of pixels written.
+uint32_t st7701_shape_circle(const st7701_surface_t *s, const st7701_rect_t *clip,
+                             float cx, float cy, float r, float width, uint16_t colour);
+uint32_t st7701_shape_arc(const st7701_surface_t *s, const st7701_rect_t *clip,
+                          float cx, float cy, float r, float width, float start, float end, uint16_t colour);
+uint32_t st7701_shape_round_rect(const st7701_surface_t *s, const st7701_rect_t *clip,
+                                 float x, float y, float w, float h, float r, float width, uint16_t colour);
+
+// A line width pixels wide, with round ends, centred on (x0, y0) - (x1, y1)
+uint32_t st7701_shape_line(const st7701_surface_t *s, const st7701_rect_t *clip,
+                           float x0, float y0, float x1, float y1, float width, uint16_t colour);
+
+// ============================================================================
+// Animation (st7701_anim.c)
+// ============================================================================
+
+#define EASE_LINEAR         0
+#define EASE_IN             1       // cubic, starts slow
+#define EASE_OUT            2       // cubic, ends slow
+#define EASE_IN_OUT         3       // smoothstep
+#define EASE_OUT_BACK       4       // overshoots a little, then settles
+
+// What a tween drives
+#define ANIM_POS            0       // overlay or sprite position, to is (x, y)
+#define ANIM_OPACITY        1       // overlay opacity, to is 0-255
+#define ANIM_SCROLL         2       // Scene scroll offset, to is (x, y)
+
+typedef struct _st7701_tween_t {
+    volatile bool active;
+    uint8_t ease;
+    bool yoyo;                  // every other leg runs backwards
+    int16_t repeat;             // legs still to run after this one, -1 forever
+    int32_t from[2];            // one or two values
+    int32_t to[2];
+    uint32_t start_us;          // esp_timer time (low 32 bits) of this leg
+    uint32_t duration_us;       // of a leg
+} st7701_tween_t;
+
+// Values of an active tween at now_us into out. Once it has finished, out
+// is its final value, it is no longer active and this returns false. Safe
+// from an ISR.
+bool st7701_tween_step(st7701_tween_t *tw, uint32_t now_us, int32_t out[2]);
+
+// Set up a tween from the values in from (values is 1 or 2) with the
+// arguments of an animate() method that follow its target and property:
+//     to, duration_ms, ease=EASE_IN_OUT, *, delay_ms=0, repeat=0, yoyo=False
+// Leaves it inactive - set active once to has been checked.
+void st7701_tween_parse(st7701_tween_t *tw, const int32_t from[2], int values,
+                        size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args);
+
+// ============================================================================
+// Screenshots (st7701_capture.c)
+// ============================================================================
+
+#define CAPTURE_RAW         0       // <HH width, height, then RGB565 pixels
+#define CAPTURE_RLE         1       // "S7RL", <HH width, height, then RLE rows
+#define CAPTURE_QOI         2       // QOI image, RGB
+
+MP_DECLARE_CONST_FUN_OBJ_KW(st7701_capture_obj);
+
+// ============================================================================
+// Screen transitions (st7701_transition.c)
+// ============================================================================
+
+#define TRANSITION_SLIDE        0       // the new screen slides in over the old one
+#define TRANSITION_WIPE         1       // the new screen is uncovered in place
+#define TRANSITION_CROSSFADE    2
+#define TRANSITION_PUSH         3       // the new screen pushes the old one off
+
+// Direction the edge moves in
+#define TRANSITION_LEFT         0
+#define TRANSITION_RIGHT        1
+#define TRANSITION_UP           2
+#define TRANSITION_DOWN         3
+
+MP_DECLARE_CONST_FUN_OBJ_KW(st7701_transition_obj);
+
+// ============================================================================
+// Stream receiver (st7701_receiver.c)
+// ============================================================================
+
+extern const mp_obj_type_t st7701_stream_receiver_type;
+
+// Stop every UART receiver decoding into display, waiting for their tasks
+void st7701_receivers_stop(st7701_obj_t *display);
+
+// ============================================================================
+// Asset cache (st7701_assets.c)
+// ============================================================================
+
+extern const mp_obj_type_t st7701_asset_cache_type;
+extern const mp_obj_type_t st7701_asset_type;
+
+// Pixels of an image asset handle, loaded again if it was evicted. Valid
+// until the next cache lookup.
+const uint16_t *st7701_asset_pixels(mp_obj_t asset_in, int *width, int *height);
+
+// Font of a font asset handle, loaded again if it was evicted
+mp_obj_t st7701_asset_font(mp_obj_t asset_in);
+
+// ============================================================================
+// Scratch arena (st7701_scratch.c)
+// ============================================================================
+
+// Staging memory in internal SRAM for the pixel kernels, from the
+// MicroPython task only. Take a mark, allocate, and release back to the
+// mark before returning (or raising).
+size_t st7701_scratch_mark(void);
+void st7701_scratch_release(size_t mark);
+
+// Between min and want bytes, as much as is free, word aligned. The size
+// given is stored in *got if it isn't NULL. Returns NULL if less than min
+// (or nothing) is free.
+void *st7701_scratch_alloc(size_t want, size_t min, size_t *got);
+
+MP_DECLARE_CONST_FUN_OBJ_1(st7701_scratch_obj);
+MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_scratch_stats_obj);
+
+// ============================================================================
+// Tracing (st7701_trace.c)
+// ============================================================================
+
+// Set to 0 to compile every trace point out
+#ifndef ST7701_TRACE
+#define ST7701_TRACE        1
+#endif
+
+// Event kinds
+#define TRACE_NATIVE        0       // span in a native function
+#define TRACE_SCANOUT       1       // span in the panel ISR
+#define TRACE_FRAME         2       // instant, the scan-out started a frame
+#define TRACE_PY_BEGIN      3       // from trace_mark()
+#define TRACE_PY_END        4
+#define TRACE_PY_MARK       5
+
+#if ST7701_TRACE
+
+extern volatile bool st7701_tracing;
+
+// Record an event named by a qstr. start and cycles are CPU cycle counts.
+// Safe from an ISR on either core.
+void st7701_trace_record(uint16_t name, uint8_t kind, uint32_t start, uint32_t cycles);
+
+typedef struct _st7701_trace_scope_t {
+    uint16_t name;
+    bool on;
+    uint32_t start;
+} st7701_trace_scope_t;
+
+static inline void st7701_trace_scope_end(st7701_trace_scope_t *scope) {
+    if (scope->on) {
+        st7701_trace_record(scope->name, TRACE_NATIVE, scope->start, esp_cpu_get_cycle_count() - scope->start);
+    }
+}
+
+// Time the rest of the enclosing block as a span. A span cut short by an
+// exception (nlr jump) is not recorded.
+#define ST7701_TRACE_SCOPE(name) \
+    st7701_trace_scope_t _trace_scope __attribute__((cleanup(st7701_trace_scope_end))) = \
+        { (name), st7701_tracing, esp_cpu_get_cycle_count() }
+
+#define ST7701_TRACE_EVENT(name, kind, start, cycles) \
+    do { \
+        if (st7701_tracing) { \
+            st7701_trace_record((name), (kind), (start), (cycles)); \
+        } \
+    } while (0)
+
+#else
+
+#define ST7701_TRACE_SCOPE(name)
+#define ST7701_TRACE_EVENT(name, kind, start, cycles)
+
+#endif // ST7701_TRACE
+
+MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_trace_begin_obj);
+MP_DECLARE_CONST_FUN_OBJ_0(st7701_trace_end_obj);
+MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_trace_mark_obj);
+MP_DECLARE_CONST_FUN_OBJ_1(st7701_trace_dump_obj);
+
+#endif // ST7701_H
@@ -0,0 +1,155 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - animation
+ *
+ * Tweens move a value (a position, an opacity, a scroll offset) from where
+ * it is to a target over a time, along an easing curve, with optional
+ * delay, repeats and back-and-forth (yoyo) legs. Python only starts and
+ * stops them. Overlay tweens are stepped by the scan-out at the start of
+ * every frame and Scene tweens by render(), both at the time the frame
+ * started, so motion follows the panel's frames and not when Python gets
+ * round to it.
+ *
+ * Stepping runs in the panel ISR, so it is integer only: progress and the
+ * easing curves are Q15 fixed point.
+ */
+
+#include "py/runtime.h"
+#include "py/obj.h"
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+#include "st7701.h"
+
+#define EASE_ONE            (1 << 15)
+#define TWEEN_MAX_MS        60000
+
+// Overshoot of EASE_OUT_BACK, the usual 1.70158 in Q15
+#define BACK_C1             55757
+#define BACK_C3             (BACK_C1 + EASE_ONE)
+
+// Eased progress for p in 0..EASE_ONE. EASE_OUT_BACK goes past EASE_ONE.
+static inline int32_t IRAM_ATTR ease(int kind, int32_t p) {
+    switch (kind) {
+        case EASE_IN:
+            return ((p * p) >> 15) * p >> 15;
+        case EASE_OUT: {
+            int32_t q = EASE_ONE - p;
+            return EASE_ONE - (((q * q) >> 15) * q >> 15);
+        }
+        case EASE_IN_OUT:
+            // Smoothstep, 3p^2 - 2p^3
+            return (int32_t)(((int64_t)((p * p) >> 15) * (3 * EASE_ONE - 2 * p)) >> 15);
+        case EASE_OUT_BACK: {
+            int32_t q = p - EASE_ONE;
+            int32_t q2 = (q * q) >> 15;
+            int32_t q3 = (q2 * q) >> 15;
+            return EASE_ONE + (int32_t)(((int64_t)BACK_C3 * q3 + (int64_t)BACK_C1 * q2) >> 15);
+        }
+        default:
+            return p;
+    }
+}
+
+bool IRAM_ATTR st7701_tween_step(st7701_tween_t *tw, uint32_t now_us, int32_t out[2]) {
+    uint32_t dur = tw->duration_us;
+    int32_t elapsed = (int32_t)(now_us - tw->start_us);
+    bool running = true;
+    int32_t p = 0;
+
+    if (elapsed > 0) {
+        // Move on by any legs that have finished since the last step
+        uint32_t legs = (uint32_t)elapsed / dur;
+        if (legs > 0) {
+            if (tw->repeat >= 0 && legs > (uint32_t)tw->repeat) {
+                legs = tw->repeat;
+                running = false;
+            }
+            if (tw->repeat > 0) {
+                tw->repeat -= legs;
+            }
+            tw->start_us += legs * dur;
+            elapsed -= legs * dur;
+            if (tw->yoyo && (legs & 1)) {
+                for (int i = 0; i < 2; i++) {
+                    int32_t t = tw->from[i];
+                    tw->from[i] = tw->to[i];
+                    tw->to[i] = t;
+                }
+            }
+        }
+
+        if (!running) {
+            p = EASE_ONE;
+        } else {
+            // (elapsed << 15) / dur without 64-bit division
+            uint32_t e = elapsed;
+            while (dur >= (1u << 16)) {
+                dur >>= 1;
+                e >>= 1;
+            }
+            p = (e << 15) / dur;
+        }
+    }
+
+    int32_t k = running ? ease(tw->ease, p) : EASE_ONE;
+    for (int i = 0; i < 2; i++) {
+        out[i] = tw->from[i] + (int32_t)(((int64_t)(tw->to[i] - tw->from[i]) * k) >> 15);
+    }
+    if (!running) {
+        tw->active = false;
+    }
+    return running;
+}
+
+// ============================================================================
+// MicroPython Interface
+// ============================================================================
+
+void st7701_tween_parse(st7701_tween_t *tw, const int32_t from[2], int values,
+                        size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_to, ARG_duration_ms, ARG_ease, ARG_delay_ms, ARG_repeat, ARG_yoyo };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_to,           MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_duration_ms,  MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ease,         MP_ARG_INT, {.u_int = EASE_IN_OUT} },
+        { MP_QSTR_delay_ms,     MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_repeat,       MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_yoyo,         MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_int_t duration_ms = args[ARG_duration_ms].u_int;
+    mp_int_t delay_ms = args[ARG_delay_ms].u_int;
+    mp_int_t kind = args[ARG_ease].u_int;
+    if (duration_ms < 1 || duration_ms > TWEEN_MAX_MS || delay_ms < 0 || delay_ms > TWEEN_MAX_MS) {
+        mp_raise_ValueError(MP_ERROR_TEXT("duration_ms or delay_ms out of range"));
+    }
+    if (kind < EASE_LINEAR || kind > EASE_OUT_BACK) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid ease"));
+    }
+
+    int32_t to[2] = { from[0], from[1] };
+    if (values == 2) {
+        mp_obj_t *items;
+        mp_obj_get_array_fixed_n(args[ARG_to].u_obj, 2, &items);
+        to[0] = mp_obj_get_int(items[0]);
+        to[1] = mp_obj_get_int(items[1]);
+    } else {
+        to[0] = mp_obj_get_int(args[ARG_to].u_obj);
+    }
+
+    // Inactive until the caller has checked it and starts it
+    tw->active = false;
+    tw->ease = kind;
+    tw->yoyo = args[ARG_yoyo].u_bool;
+    mp_int_t repeat = args[ARG_repeat].u_int;
+    tw->repeat = repeat < 0 ? -1 : (repeat > INT16_MAX ? INT16_MAX : repeat);
+    for (int i = 0; i < 2; i++) {
+        tw->from[i] = from[i];
+        tw->to[i] = to[i];
+    }
+    tw->duration_us = duration_ms * 1000;
+    tw->start_us = (uint32_t)esp_timer_get_time() + delay_ms * 1000;
+}
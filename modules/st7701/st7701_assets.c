@@ -0,0 +1,602 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - asset cache
+ *
+ * Decoded images and fonts kept in PSRAM under a byte budget, so screens
+ * that reuse icons and backgrounds don't read them from the filesystem
+ * again. Assets are keyed by path and, for images, a rotation and scale
+ * variant made from the cached original. When the budget is reached the
+ * least recently used asset is evicted, unless it is pinned.
+ *
+ * get() returns a handle. Canvas.blit(), blit_rotated(), text() and
+ * draw_text() take handles directly; a handle whose asset was evicted
+ * loads it again the next time it is drawn.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/obj.h"
+#include "py/stream.h"
+#include "py/builtin.h"
+
+#include "esp_heap_caps.h"
+
+#include "st7701.h"
+
+#define ASSET_IMAGE         0       // <HH width, height, then RGB565 (bmp2rgb.py)
+#define ASSET_FONT          1       // font2bin.py font
+
+#define ASSET_SCALE_ONE     256     // scale is 8.8 fixed point
+#define ASSET_SCALE_MAX     (16 * ASSET_SCALE_ONE)
+#define ASSET_READ_CHUNK    (16 * 1024)
+
+typedef struct _asset_entry_t {
+    struct _asset_entry_t *prev;    // LRU list, most recently used first
+    struct _asset_entry_t *next;
+    mp_obj_t path;
+    uint16_t rotation;
+    uint16_t scale;
+    uint8_t kind;
+    uint16_t pins;
+    int width;
+    int height;
+    void *data;                     // PSRAM, NULL once evicted
+    size_t size;
+    mp_obj_t font;                  // Font over data, for ASSET_FONT
+} asset_entry_t;
+
+typedef struct _st7701_asset_cache_obj_t {
+    mp_obj_base_t base;
+    asset_entry_t *head;
+    asset_entry_t *tail;
+    size_t budget;
+    size_t used;
+    uint32_t count;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+} st7701_asset_cache_obj_t;
+
+typedef struct _st7701_asset_obj_t {
+    mp_obj_base_t base;
+    st7701_asset_cache_obj_t *cache;
+    asset_entry_t *entry;           // keeps the key after an eviction
+} st7701_asset_obj_t;
+
+// ============================================================================
+// LRU List
+// ============================================================================
+
+static void lru_unlink(st7701_asset_cache_obj_t *cache, asset_entry_t *e) {
+    if (e->prev) {
+        e->prev->next = e->next;
+    } else {
+        cache->head = e->next;
+    }
+    if (e->next) {
+        e->next->prev = e->prev;
+    } else {
+        cache->tail = e->prev;
+    }
+    e->prev = e->next = NULL;
+}
+
+static void lru_push(st7701_asset_cache_obj_t *cache, asset_entry_t *e) {
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head) {
+        cache->head->prev = e;
+    } else {
+        cache->tail = e;
+    }
+    cache->head = e;
+}
+
+static void lru_touch(st7701_asset_cache_obj_t *cache, asset_entry_t *e) {
+    if (cache->head != e) {
+        lru_unlink(cache, e);
+        lru_push(cache, e);
+    }
+}
+
+static void entry_free(st7701_asset_cache_obj_t *cache, asset_entry_t *e) {
+    lru_unlink(cache, e);
+    heap_caps_free(e->data);
+    e->data = NULL;
+    e->font = mp_const_none;
+    cache->used -= e->size;
+    cache->count--;
+}
+
+// Evict least recently used assets until size more bytes fit in the budget.
+// Returns false, evicting nothing, if pinned assets leave too little room.
+static bool make_room(st7701_asset_cache_obj_t *cache, size_t size) {
+    size_t pinned = 0;
+    for (asset_entry_t *e = cache->head; e; e = e->next) {
+        if (e->pins) {
+            pinned += e->size;
+        }
+    }
+    if (pinned + size > cache->budget) {
+        return false;
+    }
+
+    asset_entry_t *e = cache->tail;
+    while (cache->used + size > cache->budget) {
+        asset_entry_t *prev = e->prev;
+        if (!e->pins) {
+            entry_free(cache, e);
+            cache->evictions++;
+        }
+        e = prev;
+    }
+    return true;
+}
+
+static asset_entry_t *cache_find(st7701_asset_cache_obj_t *cache, mp_obj_t path, int rotation, int scale) {
+    for (asset_entry_t *e = cache->head; e; e = e->next) {
+        if (e->rotation == rotation && e->scale == scale && mp_obj_equal(e->path, path)) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+// Read up to len bytes, raising on an error. Returns the number read.
+static size_t read_into(mp_obj_t file, void *buf, size_t len) {
+    int errcode;
+    mp_uint_t n = mp_stream_rw(file, buf, len, &errcode, MP_STREAM_RW_READ);
+    if (errcode != 0) {
+        mp_raise_OSError(errcode);
+    }
+    return n;
+}
+
+// Read a whole font file into e->data in PSRAM, the first 4 bytes already
+// in magic. The buffer is grown in place in e, so on a raise e->data is
+// always the live allocation for the caller to free.
+static void read_font(mp_obj_t file, const uint8_t *magic, asset_entry_t *e) {
+    e->size = ASSET_READ_CHUNK;
+    e->data = heap_caps_malloc(e->size, MALLOC_CAP_SPIRAM);
+    if (e->data == NULL) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Asset allocation failed"));
+    }
+    memcpy(e->data, magic, 4);
+    size_t len = 4;
+
+    for (;;) {
+        len += read_into(file, (uint8_t *)e->data + len, e->size - len);
+        if (len < e->size) {
+            break;
+        }
+        void *bigger = heap_caps_realloc(e->data, e->size * 2, MALLOC_CAP_SPIRAM);
+        if (bigger == NULL) {
+            mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Asset allocation failed"));
+        }
+        e->data = bigger;
+        e->size *= 2;
+    }
+
+    // Give back the unused end
+    void *fitted = heap_caps_realloc(e->data, len, MALLOC_CAP_SPIRAM);
+    if (fitted != NULL) {
+        e->data = fitted;
+    }
+    e->size = len;
+}
+
+// Decode an asset file into e->data. Images bigger than budget are
+// rejected from their header, before anything is allocated.
+static void entry_read(asset_entry_t *e, size_t budget) {
+    mp_obj_t file = mp_call_function_2(MP_OBJ_FROM_PTR(&mp_builtin_open_obj), e->path, MP_OBJ_NEW_QSTR(MP_QSTR_rb));
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        uint8_t header[4];
+        if (read_into(file, header, 4) != 4) {
+            mp_raise_ValueError(MP_ERROR_TEXT("asset file truncated"));
+        }
+
+        if (memcmp(header, "S7FT", 4) == 0) {
+            e->kind = ASSET_FONT;
+            e->width = e->height = 0;
+            read_font(file, header, e);
+        } else {
+            e->kind = ASSET_IMAGE;
+            e->width = header[0] | (header[1] << 8);
+            e->height = header[2] | (header[3] << 8);
+            // From an untrusted header, so in 64 bits
+            uint64_t size = (uint64_t)e->width * e->height * 2;
+            if (size == 0) {
+                mp_raise_ValueError(MP_ERROR_TEXT("not an image or font"));
+            }
+            if (size > budget) {
+                mp_raise_ValueError(MP_ERROR_TEXT("asset larger than the cache budget"));
+            }
+            e->size = size;
+            e->data = heap_caps_malloc(e->size, MALLOC_CAP_SPIRAM);
+            if (e->data == NULL) {
+                mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Asset allocation failed"));
+            }
+            if (read_into(file, e->data, e->size) != e->size) {
+                mp_raise_ValueError(MP_ERROR_TEXT("asset file truncated"));
+            }
+        }
+        nlr_pop();
+    } else {
+        heap_caps_free(e->data);
+        e->data = NULL;
+        mp_stream_close(file);
+        nlr_jump(nlr.ret_val);
+    }
+    mp_stream_close(file);
+}
+
+// Make a rotated (clockwise) and scaled copy of an image, nearest neighbour
+static void entry_transform(asset_entry_t *e, const asset_entry_t *src) {
+    int rw = src->width;
+    int rh = src->height;
+    if (e->rotation == 90 || e->rotation == 270) {
+        rw = src->height;
+        rh = src->width;
+    }
+    int dw = rw * e->scale / ASSET_SCALE_ONE;
+    int dh = rh * e->scale / ASSET_SCALE_ONE;
+    if (dw < 1) dw = 1;
+    if (dh < 1) dh = 1;
+
+    e->kind = ASSET_IMAGE;
+    e->width = dw;
+    e->height = dh;
+    e->size = dw * dh * 2;
+    e->data = heap_caps_malloc(e->size, MALLOC_CAP_SPIRAM);
+    if (e->data == NULL) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Asset allocation failed"));
+    }
+
+    int base, sx, sy;
+    st7701_rotation_steps(e->rotation, src->width, src->height, &base, &sx, &sy);
+    const uint16_t *in = src->data;
+    uint16_t *out = e->data;
+
+    // Source offsets of the columns, from the scratch arena, or worked out
+    // for every pixel if there's no room
+    size_t mark = st7701_scratch_mark();
+    int *cols = st7701_scratch_alloc(dw * sizeof(int), dw * sizeof(int), NULL);
+    if (cols == NULL) {
+        for (int y = 0; y < dh; y++) {
+            const uint16_t *row = in + base + y * rh / dh * sy;
+            for (int x = 0; x < dw; x++) {
+                *out++ = row[x * rw / dw * sx];
+            }
+        }
+        return;
+    }
+    for (int x = 0; x < dw; x++) {
+        cols[x] = x * rw / dw * sx;
+    }
+    for (int y = 0; y < dh; y++) {
+        const uint16_t *row = in + base + y * rh / dh * sy;
+        for (int x = 0; x < dw; x++) {
+            *out++ = row[cols[x]];
+        }
+    }
+    st7701_scratch_release(mark);
+}
+
+// Look up an asset, loading it on a miss
+static asset_entry_t *cache_get(st7701_asset_cache_obj_t *cache, mp_obj_t path, int rotation, int scale) {
+    asset_entry_t *e = cache_find(cache, path, rotation, scale);
+    if (e != NULL) {
+        cache->hits++;
+        lru_touch(cache, e);
+        return e;
+    }
+    cache->misses++;
+
+    e = m_new_obj(asset_entry_t);
+    memset(e, 0, sizeof(*e));
+    e->path = path;
+    e->rotation = rotation;
+    e->scale = scale;
+    e->font = mp_const_none;
+
+    asset_entry_t *src = NULL;
+    if (rotation != 0 || scale != ASSET_SCALE_ONE) {
+        // Variants are made from the original, which is cached too. It
+        // stays pinned until there is room for the variant, so it is only
+        // evicted for it if the two don't fit in the budget together.
+        src = cache_get(cache, path, 0, ASSET_SCALE_ONE);
+        if (src->kind != ASSET_IMAGE) {
+            mp_raise_ValueError(MP_ERROR_TEXT("only images can be rotated or scaled"));
+        }
+        src->pins++;
+        nlr_buf_t nlr;
+        if (nlr_push(&nlr) == 0) {
+            entry_transform(e, src);
+            nlr_pop();
+        } else {
+            src->pins--;
+            nlr_jump(nlr.ret_val);
+        }
+    } else {
+        entry_read(e, cache->budget);
+    }
+
+    bool room = make_room(cache, e->size);
+    if (src != NULL) {
+        src->pins--;
+        if (!room) {
+            room = make_room(cache, e->size);
+        }
+    }
+    if (!room) {
+        heap_caps_free(e->data);
+        e->data = NULL;
+        if (e->size > cache->budget) {
+            mp_raise_ValueError(MP_ERROR_TEXT("asset larger than the cache budget"));
+        }
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("asset cache full of pinned assets"));
+    }
+
+    if (e->kind == ASSET_FONT) {
+        nlr_buf_t nlr;
+        if (nlr_push(&nlr) == 0) {
+            mp_obj_t data = mp_obj_new_memoryview('B', e->size, e->data);
+            e->font = mp_call_function_1(MP_OBJ_FROM_PTR(&st7701_font_type), data);
+            nlr_pop();
+        } else {
+            heap_caps_free(e->data);
+            e->data = NULL;
+            nlr_jump(nlr.ret_val);
+        }
+    }
+
+    lru_push(cache, e);
+    cache->used += e->size;
+    cache->count++;
+    return e;
+}
+
+// The entry behind a handle, loading it again if it was evicted
+static asset_entry_t *asset_resolve(mp_obj_t asset_in) {
+    st7701_asset_obj_t *self = MP_OBJ_TO_PTR(asset_in);
+    asset_entry_t *e = self->entry;
+    if (e->data != NULL) {
+        self->cache->hits++;
+        lru_touch(self->cache, e);
+        return e;
+    }
+    self->entry = cache_get(self->cache, e->path, e->rotation, e->scale);
+    return self->entry;
+}
+
+const uint16_t *st7701_asset_pixels(mp_obj_t asset_in, int *width, int *height) {
+    asset_entry_t *e = asset_resolve(asset_in);
+    if (e->kind != ASSET_IMAGE) {
+        mp_raise_TypeError(MP_ERROR_TEXT("asset is not an image"));
+    }
+    *width = e->width;
+    *height = e->height;
+    return e->data;
+}
+
+mp_obj_t st7701_asset_font(mp_obj_t asset_in) {
+    asset_entry_t *e = asset_resolve(asset_in);
+    if (e->kind != ASSET_FONT) {
+        mp_raise_TypeError(MP_ERROR_TEXT("asset is not a font"));
+    }
+    return e->font;
+}
+
+// ============================================================================
+// MicroPython Interface - Asset
+// ============================================================================
+
+// width(), height() - image size, after rotation and scaling
+static mp_obj_t asset_width(mp_obj_t self_in) {
+    int w, h;
+    st7701_asset_pixels(self_in, &w, &h);
+    return MP_OBJ_NEW_SMALL_INT(w);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(asset_width_obj, asset_width);
+
+static mp_obj_t asset_height(mp_obj_t self_in) {
+    int w, h;
+    st7701_asset_pixels(self_in, &w, &h);
+    return MP_OBJ_NEW_SMALL_INT(h);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(asset_height_obj, asset_height);
+
+// pin() - keep the asset loaded until the matching unpin()
+static mp_obj_t asset_pin(mp_obj_t self_in) {
+    st7701_asset_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    asset_resolve(self_in);
+    self->entry->pins++;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(asset_pin_obj, asset_pin);
+
+static mp_obj_t asset_unpin(mp_obj_t self_in) {
+    st7701_asset_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->entry->pins == 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("asset not pinned"));
+    }
+    self->entry->pins--;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(asset_unpin_obj, asset_unpin);
+
+// pixels() -> memoryview of the RGB565 pixels, e.g. for framebuf. Only
+// valid while the asset is pinned.
+static mp_obj_t asset_pixels(mp_obj_t self_in) {
+    int w, h;
+    const uint16_t *pixels = st7701_asset_pixels(self_in, &w, &h);
+    return mp_obj_new_memoryview('B', w * h * 2, (void *)pixels);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(asset_pixels_obj, asset_pixels);
+
+static const mp_rom_map_elem_t asset_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_width),       MP_ROM_PTR(&asset_width_obj) },
+    { MP_ROM_QSTR(MP_QSTR_height),      MP_ROM_PTR(&asset_height_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pin),         MP_ROM_PTR(&asset_pin_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpin),       MP_ROM_PTR(&asset_unpin_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pixels),      MP_ROM_PTR(&asset_pixels_obj) },
+};
+static MP_DEFINE_CONST_DICT(asset_locals_dict, asset_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    st7701_asset_type,
+    MP_QSTR_Asset,
+    MP_TYPE_FLAG_NONE,
+    locals_dict, &asset_locals_dict
+);
+
+// ============================================================================
+// MicroPython Interface - AssetCache
+// ============================================================================
+
+// AssetCache(budget) - budget is in bytes of PSRAM
+static mp_obj_t cache_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    mp_int_t budget = mp_obj_get_int(args[0]);
+    if (budget <= 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("budget must be positive"));
+    }
+
+    st7701_asset_cache_obj_t *self = m_new_obj_with_finaliser(st7701_asset_cache_obj_t);
+    self->base.type = type;
+    self->head = self->tail = NULL;
+    self->budget = budget;
+    self->used = 0;
+    self->count = 0;
+    self->hits = self->misses = self->evictions = 0;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// get(path, rotation=0, scale=1.0) -> Asset
+// rotation is clockwise, 0, 90, 180 or 270. scale is 1/16 to 16.
+static mp_obj_t cache_get_method(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_get);
+    enum { ARG_self, ARG_path, ARG_rotation, ARG_scale };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_self,     MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_path,     MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_rotation, MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_scale,    MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    st7701_asset_cache_obj_t *self = MP_OBJ_TO_PTR(args[ARG_self].u_obj);
+    mp_obj_t path = args[ARG_path].u_obj;
+    if (!mp_obj_is_str(path)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("path must be a str"));
+    }
+    mp_int_t rotation = args[ARG_rotation].u_int;
+    if (rotation != 0 && rotation != 90 && rotation != 180 && rotation != 270) {
+        mp_raise_ValueError(MP_ERROR_TEXT("rotation must be 0, 90, 180 or 270"));
+    }
+    int scale = ASSET_SCALE_ONE;
+    if (args[ARG_scale].u_obj != mp_const_none) {
+        scale = (int)(mp_obj_get_float(args[ARG_scale].u_obj) * ASSET_SCALE_ONE + 0.5f);
+        if (scale < ASSET_SCALE_ONE / 16 || scale > ASSET_SCALE_MAX) {
+            mp_raise_ValueError(MP_ERROR_TEXT("scale out of range"));
+        }
+    }
+
+    st7701_asset_obj_t *asset = mp_obj_malloc(st7701_asset_obj_t, &st7701_asset_type);
+    asset->cache = self;
+    asset->entry = cache_get(self, path, rotation, scale);
+    return MP_OBJ_FROM_PTR(asset);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(cache_get_obj, 2, cache_get_method);
+
+// budget([bytes]) -> budget. Lowering it evicts unpinned assets to fit.
+static mp_obj_t cache_budget(size_t n_args, const mp_obj_t *args) {
+    st7701_asset_cache_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (n_args > 1) {
+        mp_int_t budget = mp_obj_get_int(args[1]);
+        if (budget <= 0) {
+            mp_raise_ValueError(MP_ERROR_TEXT("budget must be positive"));
+        }
+        self->budget = budget;
+        asset_entry_t *e = self->tail;
+        while (e && self->used > self->budget) {
+            asset_entry_t *prev = e->prev;
+            if (!e->pins) {
+                entry_free(self, e);
+                self->evictions++;
+            }
+            e = prev;
+        }
+    }
+    return mp_obj_new_int_from_uint(self->budget);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(cache_budget_obj, 1, 2, cache_budget);
+
+// stats([reset]) -> (hits, misses, evictions, used, count)
+// Every get() and every draw of a handle is a lookup
+static mp_obj_t cache_stats(size_t n_args, const mp_obj_t *args) {
+    st7701_asset_cache_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_obj_t tuple[5] = {
+        mp_obj_new_int_from_uint(self->hits),
+        mp_obj_new_int_from_uint(self->misses),
+        mp_obj_new_int_from_uint(self->evictions),
+        mp_obj_new_int_from_uint(self->used),
+        mp_obj_new_int_from_uint(self->count),
+    };
+    if (n_args > 1 && mp_obj_is_true(args[1])) {
+        self->hits = self->misses = self->evictions = 0;
+    }
+    return mp_obj_new_tuple(5, tuple);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(cache_stats_obj, 1, 2, cache_stats);
+
+// clear() - evict every asset that isn't pinned
+static mp_obj_t cache_clear(mp_obj_t self_in) {
+    st7701_asset_cache_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    asset_entry_t *e = self->head;
+    while (e) {
+        asset_entry_t *next = e->next;
+        if (!e->pins) {
+            entry_free(self, e);
+        }
+        e = next;
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(cache_clear_obj, cache_clear);
+
+// close() - free everything, pinned or not. Also the finaliser.
+static mp_obj_t cache_close(mp_obj_t self_in) {
+    st7701_asset_cache_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    while (self->head) {
+        self->head->pins = 0;
+        entry_free(self, self->head);
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(cache_close_obj, cache_close);
+
+static const mp_rom_map_elem_t cache_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_get),         MP_ROM_PTR(&cache_get_obj) },
+    { MP_ROM_QSTR(MP_QSTR_budget),      MP_ROM_PTR(&cache_budget_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats),       MP_ROM_PTR(&cache_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clear),       MP_ROM_PTR(&cache_clear_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close),       MP_ROM_PTR(&cache_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__),     MP_ROM_PTR(&cache_close_obj) },
+};
+static MP_DEFINE_CONST_DICT(cache_locals_dict, cache_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    st7701_asset_cache_type,
+    MP_QSTR_AssetCache,
+    MP_TYPE_FLAG_NONE,
+    make_new, cache_make_new,
+    locals_dict, &cache_locals_dict
+);
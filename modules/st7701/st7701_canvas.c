@@ -0,0 +1,564 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - canvas
+ *
+ * A drawing context on a display buffer or an offscreen RGB565 buffer, with
+ * an origin and a stack of clip rectangles. Every primitive takes local
+ * coordinates and is clipped natively, so widget code needs no bounds
+ * checks of its own.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/obj.h"
+
+#include "st7701.h"
+
+// ============================================================================
+// Target
+// ============================================================================
+
+void st7701_canvas_surface(st7701_canvas_obj_t *self, st7701_surface_t *surface) {
+    if (self->pixels != NULL) {
+        surface->pixels = self->pixels;
+        surface->width = self->width;
+        surface->height = self->height;
+        surface->stride = self->width;
+        return;
+    }
+
+    st7701_obj_t *display = MP_OBJ_TO_PTR(self->target);
+    st7701_get_surface(display, surface);
+    if (self->which == CANVAS_FRONT) {
+        surface->pixels = (uint16_t *)st7701_front_buffer(display);
+    } else if (self->which >= 0) {
+        surface->pixels = display->buffers[self->which];
+    }
+}
+
+static void canvas_reset(st7701_canvas_obj_t *self) {
+    self->ox = 0;
+    self->oy = 0;
+    self->clip.x0 = 0;
+    self->clip.y0 = 0;
+    self->clip.x1 = self->width;
+    self->clip.y1 = self->height;
+    self->depth = 0;
+}
+
+// ============================================================================
+// Primitives
+// ============================================================================
+
+// Fill a rectangle in local coordinates, clipped
+static void canvas_fill_rect(st7701_canvas_obj_t *self, const st7701_surface_t *s,
+                             int x, int y, int w, int h, uint16_t colour) {
+    int x0 = x + self->ox;
+    int y0 = y + self->oy;
+    int x1 = x0 + w;
+    int y1 = y0 + h;
+    if (x0 < self->clip.x0) x0 = self->clip.x0;
+    if (y0 < self->clip.y0) y0 = self->clip.y0;
+    if (x1 > self->clip.x1) x1 = self->clip.x1;
+    if (y1 > self->clip.y1) y1 = self->clip.y1;
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    uint16_t *row = s->pixels + y0 * s->stride + x0;
+    for (int yy = y0; yy < y1; yy++, row += s->stride) {
+        st7701_fill_span(row, x1 - x0, colour);
+    }
+}
+
+// Copy RGB565 pixels with top-left at local (x, y), skipping key if >= 0
+static void canvas_blit(st7701_canvas_obj_t *self, const st7701_surface_t *s, const uint16_t *src,
+                        int x, int y, int w, int h, int32_t key) {
+    int x0 = x + self->ox;
+    int y0 = y + self->oy;
+    int x1 = x0 + w;
+    int y1 = y0 + h;
+    int sx = 0;
+    int sy = 0;
+    if (x0 < self->clip.x0) { sx = self->clip.x0 - x0; x0 = self->clip.x0; }
+    if (y0 < self->clip.y0) { sy = self->clip.y0 - y0; y0 = self->clip.y0; }
+    if (x1 > self->clip.x1) x1 = self->clip.x1;
+    if (y1 > self->clip.y1) y1 = self->clip.y1;
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    int n = x1 - x0;
+    const uint16_t *in = src + sy * w + sx;
+    uint16_t *out = s->pixels + y0 * s->stride + x0;
+    for (int yy = y0; yy < y1; yy++, in += w, out += s->stride) {
+        if (key < 0) {
+            memcpy(out, in, n * 2);
+        } else {
+            for (int i = 0; i < n; i++) {
+                if (in[i] != (uint16_t)key) {
+                    out[i] = in[i];
+                }
+            }
+        }
+    }
+}
+
+// Copy a w x h image rotated clockwise by degrees, top-left at local (x, y)
+static void canvas_blit_rotated(st7701_canvas_obj_t *self, const st7701_surface_t *s, const uint16_t *src,
+                                int x, int y, int w, int h, int degrees, int32_t key) {
+    int dw = w;
+    int dh = h;
+    if (degrees == 90 || degrees == 270) {
+        dw = h;
+        dh = w;
+    }
+    int x0 = x + self->ox;
+    int y0 = y + self->oy;
+    int x1 = x0 + dw;
+    int y1 = y0 + dh;
+    int sx = 0;
+    int sy = 0;
+    if (x0 < self->clip.x0) { sx = self->clip.x0 - x0; x0 = self->clip.x0; }
+    if (y0 < self->clip.y0) { sy = self->clip.y0 - y0; y0 = self->clip.y0; }
+    if (x1 > self->clip.x1) x1 = self->clip.x1;
+    if (y1 > self->clip.y1) y1 = self->clip.y1;
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    int base, dx, dy;
+    st7701_rotation_steps(degrees, w, h, &base, &dx, &dy);
+    const uint16_t *in = src + base + sx * dx + sy * dy;
+    uint16_t *out = s->pixels + y0 * s->stride + x0;
+    int n = x1 - x0;
+    for (int yy = y0; yy < y1; yy++, in += dy, out += s->stride) {
+        const uint16_t *p = in;
+        for (int i = 0; i < n; i++, p += dx) {
+            if (key < 0 || *p != (uint16_t)key) {
+                out[i] = *p;
+            }
+        }
+    }
+}
+
+// Source pixels for blit() and blit_rotated(), from (self, src, x, y, ...):
+// an asset handle, or a buffer with w and h after x and y. Returns the index
+// of the argument after them.
+static size_t canvas_get_image(size_t n_args, const mp_obj_t *args, const uint16_t **pixels, int *w, int *h) {
+    if (mp_obj_is_type(args[1], &st7701_asset_type)) {
+        *pixels = st7701_asset_pixels(args[1], w, h);
+        return 4;
+    }
+    if (n_args < 6) {
+        mp_raise_TypeError(MP_ERROR_TEXT("buffer needs w and h"));
+    }
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_READ);
+    *w = mp_obj_get_int(args[4]);
+    *h = mp_obj_get_int(args[5]);
+    if (*w > 0 && *h > 0 && bufinfo.len < (size_t)*w * *h * 2) {
+        mp_raise_ValueError(MP_ERROR_TEXT("buffer too small for dimensions"));
+    }
+    *pixels = bufinfo.buf;
+    return 6;
+}
+
+// ============================================================================
+// MicroPython Interface
+// ============================================================================
+
+// Canvas(display, [which])  - which is Canvas.BACK (default), Canvas.FRONT or a buffer index
+// Canvas(buffer, w, h)      - offscreen RGB565 buffer
+static mp_obj_t canvas_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 3, false);
+
+    st7701_canvas_obj_t *self = mp_obj_malloc(st7701_canvas_obj_t, type);
+    self->target = args[0];
+    self->which = CANVAS_BACK;
+    self->pixels = NULL;
+    self->view_obj = mp_const_none;
+    self->view_pixels = NULL;
+
+    if (mp_obj_is_type(args[0], &st7701_type)) {
+        st7701_obj_t *display = MP_OBJ_TO_PTR(args[0]);
+        if (n_args > 1) {
+            self->which = mp_obj_get_int(args[1]);
+            if (self->which != CANVAS_BACK && self->which != CANVAS_FRONT &&
+                (self->which < 0 || self->which >= display->num_buffers)) {
+                mp_raise_ValueError(MP_ERROR_TEXT("invalid buffer"));
+            }
+        }
+        self->width = display->width;
+        self->height = display->height;
+    } else {
+        if (n_args != 3) {
+            mp_raise_TypeError(MP_ERROR_TEXT("offscreen canvas needs buffer, w and h"));
+        }
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_RW);
+        self->width = mp_obj_get_int(args[1]);
+        self->height = mp_obj_get_int(args[2]);
+        if (self->width <= 0 || self->height <= 0) {
+            mp_raise_ValueError(MP_ERROR_TEXT("invalid canvas size"));
+        }
+        if (bufinfo.len < (size_t)self->width * self->height * 2) {
+            mp_raise_ValueError(MP_ERROR_TEXT("buffer too small for dimensions"));
+        }
+        self->pixels = bufinfo.buf;
+    }
+
+    canvas_reset(self);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// view() -> 'H' memoryview of the pixels, index with y * width + x
+static mp_obj_t canvas_view(mp_obj_t self_in) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+
+    if (self->view_pixels != s.pixels) {
+        self->view_obj = mp_obj_new_memoryview('H' | 0x80, s.width * s.height, s.pixels);
+        self->view_pixels = s.pixels;
+    }
+    return self->view_obj;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(canvas_view_obj, canvas_view);
+
+// width(), height()
+static mp_obj_t canvas_width(mp_obj_t self_in) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return MP_OBJ_NEW_SMALL_INT(self->width);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(canvas_width_obj, canvas_width);
+
+static mp_obj_t canvas_height(mp_obj_t self_in) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return MP_OBJ_NEW_SMALL_INT(self->height);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(canvas_height_obj, canvas_height);
+
+// translate(dx, dy) - move the origin, relative to the current one
+static mp_obj_t canvas_translate(mp_obj_t self_in, mp_obj_t dx_in, mp_obj_t dy_in) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    self->ox += mp_obj_get_int(dx_in);
+    self->oy += mp_obj_get_int(dy_in);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(canvas_translate_obj, canvas_translate);
+
+// origin() -> (x, y) of the local origin on the surface
+static mp_obj_t canvas_origin(mp_obj_t self_in) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t items[2] = { MP_OBJ_NEW_SMALL_INT(self->ox), MP_OBJ_NEW_SMALL_INT(self->oy) };
+    return mp_obj_new_tuple(2, items);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(canvas_origin_obj, canvas_origin);
+
+// push_clip(x, y, w, h) - save the origin and clip, then narrow the clip to
+// a local rectangle. With translate() this gives a widget its own space.
+static mp_obj_t canvas_push_clip(size_t n_args, const mp_obj_t *args) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (self->depth == CANVAS_CLIP_DEPTH) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("clip stack full"));
+    }
+    self->stack[self->depth].ox = self->ox;
+    self->stack[self->depth].oy = self->oy;
+    self->stack[self->depth].clip = self->clip;
+    self->depth++;
+
+    int x0 = mp_obj_get_int(args[1]) + self->ox;
+    int y0 = mp_obj_get_int(args[2]) + self->oy;
+    int x1 = x0 + mp_obj_get_int(args[3]);
+    int y1 = y0 + mp_obj_get_int(args[4]);
+    if (x0 > self->clip.x0) self->clip.x0 = x0;
+    if (y0 > self->clip.y0) self->clip.y0 = y0;
+    if (x1 < self->clip.x1) self->clip.x1 = x1;
+    if (y1 < self->clip.y1) self->clip.y1 = y1;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_push_clip_obj, 5, 5, canvas_push_clip);
+
+// pop_clip() - restore the origin and clip saved by the matching push_clip()
+static mp_obj_t canvas_pop_clip(mp_obj_t self_in) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->depth == 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("clip stack empty"));
+    }
+    self->depth--;
+    self->ox = self->stack[self->depth].ox;
+    self->oy = self->stack[self->depth].oy;
+    self->clip = self->stack[self->depth].clip;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(canvas_pop_clip_obj, canvas_pop_clip);
+
+// clip() -> (x, y, w, h) of the clip in local coordinates, w or h 0 if empty
+static mp_obj_t canvas_clip(mp_obj_t self_in) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    int w = self->clip.x1 - self->clip.x0;
+    int h = self->clip.y1 - self->clip.y0;
+    mp_obj_t items[4] = {
+        MP_OBJ_NEW_SMALL_INT(self->clip.x0 - self->ox),
+        MP_OBJ_NEW_SMALL_INT(self->clip.y0 - self->oy),
+        MP_OBJ_NEW_SMALL_INT(w > 0 ? w : 0),
+        MP_OBJ_NEW_SMALL_INT(h > 0 ? h : 0),
+    };
+    return mp_obj_new_tuple(4, items);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(canvas_clip_obj, canvas_clip);
+
+// reset() - origin back to (0, 0), clip to the whole surface, stack emptied
+static mp_obj_t canvas_reset_method(mp_obj_t self_in) {
+    canvas_reset(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(canvas_reset_obj, canvas_reset_method);
+
+// fill(colour) - fill the clip rectangle
+static mp_obj_t canvas_fill(mp_obj_t self_in, mp_obj_t colour_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_fill);
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+    canvas_fill_rect(self, &s, self->clip.x0 - self->ox, self->clip.y0 - self->oy,
+                     self->clip.x1 - self->clip.x0, self->clip.y1 - self->clip.y0, mp_obj_get_int(colour_in));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(canvas_fill_obj, canvas_fill);
+
+// fill_rect(x, y, w, h, colour)
+static mp_obj_t canvas_fill_rect_method(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_fill_rect);
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+    canvas_fill_rect(self, &s, mp_obj_get_int(args[1]), mp_obj_get_int(args[2]),
+                     mp_obj_get_int(args[3]), mp_obj_get_int(args[4]), mp_obj_get_int(args[5]));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_fill_rect_obj, 6, 6, canvas_fill_rect_method);
+
+// hline(x, y, w, colour)
+static mp_obj_t canvas_hline(size_t n_args, const mp_obj_t *args) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+    canvas_fill_rect(self, &s, mp_obj_get_int(args[1]), mp_obj_get_int(args[2]),
+                     mp_obj_get_int(args[3]), 1, mp_obj_get_int(args[4]));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_hline_obj, 5, 5, canvas_hline);
+
+// vline(x, y, h, colour)
+static mp_obj_t canvas_vline(size_t n_args, const mp_obj_t *args) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+    canvas_fill_rect(self, &s, mp_obj_get_int(args[1]), mp_obj_get_int(args[2]),
+                     1, mp_obj_get_int(args[3]), mp_obj_get_int(args[4]));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_vline_obj, 5, 5, canvas_vline);
+
+// pixel(x, y, [colour]) - set a pixel, or get it (None if clipped)
+static mp_obj_t canvas_pixel(size_t n_args, const mp_obj_t *args) {
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+    int x = mp_obj_get_int(args[1]) + self->ox;
+    int y = mp_obj_get_int(args[2]) + self->oy;
+    if (x < self->clip.x0 || x >= self->clip.x1 || y < self->clip.y0 || y >= self->clip.y1) {
+        return mp_const_none;
+    }
+    uint16_t *p = s.pixels + y * s.stride + x;
+    if (n_args == 3) {
+        return MP_OBJ_NEW_SMALL_INT(*p);
+    }
+    *p = mp_obj_get_int(args[3]);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_pixel_obj, 3, 4, canvas_pixel);
+
+// blit(buffer, x, y, w, h, [key]) or blit(asset, x, y, [key]) - RGB565
+// pixels, key is a transparent colour
+static mp_obj_t canvas_blit_method(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_blit);
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+
+    const uint16_t *pixels;
+    int w, h;
+    size_t next = canvas_get_image(n_args, args, &pixels, &w, &h);
+    if (n_args > next + 1) {
+        mp_raise_TypeError(MP_ERROR_TEXT("too many arguments"));
+    }
+    if (w <= 0 || h <= 0) {
+        return mp_const_none;
+    }
+    int32_t key = n_args > next ? mp_obj_get_int(args[next]) : -1;
+
+    canvas_blit(self, &s, pixels, mp_obj_get_int(args[2]), mp_obj_get_int(args[3]), w, h, key);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_blit_obj, 4, 7, canvas_blit_method);
+
+// blit_rotated(buffer, x, y, w, h, degrees, [key]) or blit_rotated(asset, x, y, degrees, [key])
+// Copy an image turned clockwise by 90, 180 or 270 degrees, leaving the
+// source as it is. (x, y) is the top-left of the rotated image.
+static mp_obj_t canvas_blit_rotated_method(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_blit_rotated);
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+
+    const uint16_t *pixels;
+    int w, h;
+    size_t next = canvas_get_image(n_args, args, &pixels, &w, &h);
+    if (n_args < next + 1) {
+        mp_raise_TypeError(MP_ERROR_TEXT("missing degrees"));
+    }
+    if (n_args > next + 2) {
+        mp_raise_TypeError(MP_ERROR_TEXT("too many arguments"));
+    }
+    mp_int_t degrees = mp_obj_get_int(args[next]);
+    if (degrees != 0 && degrees != 90 && degrees != 180 && degrees != 270) {
+        mp_raise_ValueError(MP_ERROR_TEXT("degrees must be 0, 90, 180 or 270"));
+    }
+    if (w <= 0 || h <= 0) {
+        return mp_const_none;
+    }
+    int32_t key = n_args > next + 1 ? mp_obj_get_int(args[next + 1]) : -1;
+
+    canvas_blit_rotated(self, &s, pixels, mp_obj_get_int(args[2]), mp_obj_get_int(args[3]), w, h, degrees, key);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_blit_rotated_obj, 5, 8, canvas_blit_rotated_method);
+
+// text(font, text, x, y, colour, [bg]) -> local x after the last glyph
+// font is a Font or a font asset
+static mp_obj_t canvas_text(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_text);
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+
+    size_t len;
+    const char *str = mp_obj_str_get_data(args[2], &len);
+    int x = mp_obj_get_int(args[3]) + self->ox;
+    int y = mp_obj_get_int(args[4]) + self->oy;
+    uint16_t colour = mp_obj_get_int(args[5]);
+    int32_t bg = n_args > 6 ? mp_obj_get_int(args[6]) : -1;
+
+    int end = st7701_text_draw(&s, &self->clip, args[1], str, len, x, y, colour, bg);
+    return mp_obj_new_int(end - self->ox);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_text_obj, 6, 7, canvas_text);
+
+// ============================================================================
+// Anti-aliased Shapes
+// ============================================================================
+
+// Positions, sizes and widths may be fractional. Each returns the number of
+// pixels written, so the cost of a frame of shapes can be measured.
+
+static mp_obj_t canvas_shape_result(uint32_t pixels) {
+    return mp_obj_new_int_from_uint(pixels);
+}
+
+// circle(x, y, r, colour, [width]) - filled, or a ring width pixels thick
+// inside radius r
+static mp_obj_t canvas_circle(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_circle);
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+    float width = n_args > 5 ? mp_obj_get_float(args[5]) : 0;
+    return canvas_shape_result(st7701_shape_circle(&s, &self->clip,
+        mp_obj_get_float(args[1]) + self->ox, mp_obj_get_float(args[2]) + self->oy,
+        mp_obj_get_float(args[3]), width, mp_obj_get_int(args[4])));
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_circle_obj, 5, 6, canvas_circle);
+
+// arc(x, y, r, start, end, colour, [width]) - from start to end degrees,
+// clockwise from 12 o'clock. Without a width it is a filled pie slice.
+static mp_obj_t canvas_arc(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_arc);
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+    float width = n_args > 7 ? mp_obj_get_float(args[7]) : 0;
+    return canvas_shape_result(st7701_shape_arc(&s, &self->clip,
+        mp_obj_get_float(args[1]) + self->ox, mp_obj_get_float(args[2]) + self->oy,
+        mp_obj_get_float(args[3]), width, mp_obj_get_float(args[4]), mp_obj_get_float(args[5]),
+        mp_obj_get_int(args[6])));
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_arc_obj, 7, 8, canvas_arc);
+
+// round_rect(x, y, w, h, r, colour, [width]) - covers the same pixels as
+// fill_rect(x, y, w, h), with corners of radius r. With a width, only an
+// outline that thick.
+static mp_obj_t canvas_round_rect(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_round_rect);
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+    float width = n_args > 7 ? mp_obj_get_float(args[7]) : 0;
+    return canvas_shape_result(st7701_shape_round_rect(&s, &self->clip,
+        mp_obj_get_float(args[1]) + self->ox, mp_obj_get_float(args[2]) + self->oy,
+        mp_obj_get_float(args[3]), mp_obj_get_float(args[4]), mp_obj_get_float(args[5]),
+        width, mp_obj_get_int(args[6])));
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_round_rect_obj, 7, 8, canvas_round_rect);
+
+// line(x0, y0, x1, y1, colour, [width]) - width 1 by default, round ends
+static mp_obj_t canvas_line(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_line);
+    st7701_canvas_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t s;
+    st7701_canvas_surface(self, &s);
+    float width = n_args > 6 ? mp_obj_get_float(args[6]) : 1;
+    return canvas_shape_result(st7701_shape_line(&s, &self->clip,
+        mp_obj_get_float(args[1]) + self->ox, mp_obj_get_float(args[2]) + self->oy,
+        mp_obj_get_float(args[3]) + self->ox, mp_obj_get_float(args[4]) + self->oy,
+        width, mp_obj_get_int(args[5])));
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(canvas_line_obj, 6, 7, canvas_line);
+
+static const mp_rom_map_elem_t canvas_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_view),        MP_ROM_PTR(&canvas_view_obj) },
+    { MP_ROM_QSTR(MP_QSTR_width),       MP_ROM_PTR(&canvas_width_obj) },
+    { MP_ROM_QSTR(MP_QSTR_height),      MP_ROM_PTR(&canvas_height_obj) },
+    { MP_ROM_QSTR(MP_QSTR_translate),   MP_ROM_PTR(&canvas_translate_obj) },
+    { MP_ROM_QSTR(MP_QSTR_origin),      MP_ROM_PTR(&canvas_origin_obj) },
+    { MP_ROM_QSTR(MP_QSTR_push_clip),   MP_ROM_PTR(&canvas_push_clip_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pop_clip),    MP_ROM_PTR(&canvas_pop_clip_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clip),        MP_ROM_PTR(&canvas_clip_obj) },
+    { MP_ROM_QSTR(MP_QSTR_reset),       MP_ROM_PTR(&canvas_reset_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fill),        MP_ROM_PTR(&canvas_fill_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fill_rect),   MP_ROM_PTR(&canvas_fill_rect_obj) },
+    { MP_ROM_QSTR(MP_QSTR_hline),       MP_ROM_PTR(&canvas_hline_obj) },
+    { MP_ROM_QSTR(MP_QSTR_vline),       MP_ROM_PTR(&canvas_vline_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pixel),       MP_ROM_PTR(&canvas_pixel_obj) },
+    { MP_ROM_QSTR(MP_QSTR_blit),        MP_ROM_PTR(&canvas_blit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_blit_rotated), MP_ROM_PTR(&canvas_blit_rotated_obj) },
+    { MP_ROM_QSTR(MP_QSTR_text),        MP_ROM_PTR(&canvas_text_obj) },
+    { MP_ROM_QSTR(MP_QSTR_circle),      MP_ROM_PTR(&canvas_circle_obj) },
+    { MP_ROM_QSTR(MP_QSTR_arc),         MP_ROM_PTR(&canvas_arc_obj) },
+    { MP_ROM_QSTR(MP_QSTR_round_rect),  MP_ROM_PTR(&canvas_round_rect_obj) },
+    { MP_ROM_QSTR(MP_QSTR_line),        MP_ROM_PTR(&canvas_line_obj) },
+
+    { MP_ROM_QSTR(MP_QSTR_BACK),        MP_ROM_INT(CANVAS_BACK) },
+    { MP_ROM_QSTR(MP_QSTR_FRONT),       MP_ROM_INT(CANVAS_FRONT) },
+};
+static MP_DEFINE_CONST_DICT(canvas_locals_dict, canvas_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    st7701_canvas_type,
+    MP_QSTR_Canvas,
+    MP_TYPE_FLAG_NONE,
+    make_new, canvas_make_new,
+    locals_dict, &canvas_locals_dict
+);
@@ -0,0 +1,341 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - screenshots
+ *
+ * Rows are composed exactly as the scan-out sends them (framebuffer,
+ * overlays, colour LUT) one at a time into a staging row in the scratch
+ * arena, encoded, and written to the file through an output buffer of up to
+ * 4KB from the arena too, so a capture never needs a copy of the whole
+ * frame.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/obj.h"
+#include "py/stream.h"
+#include "py/builtin.h"
+#include "py/mperrno.h"
+
+#include "st7701.h"
+
+#define CAPTURE_OUT_SIZE    4096
+#define CAPTURE_OUT_MIN     512     // fits the longest RLE literal run
+
+// ============================================================================
+// Output
+// ============================================================================
+
+typedef struct _capture_out_t {
+    mp_obj_t file;
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    uint32_t total;
+} capture_out_t;
+
+static void out_flush(capture_out_t *out) {
+    if (out->len == 0) {
+        return;
+    }
+    int errcode;
+    mp_uint_t n = mp_stream_rw(out->file, out->buf, out->len, &errcode, MP_STREAM_RW_WRITE);
+    if (errcode != 0) {
+        mp_raise_OSError(errcode);
+    }
+    if (n != out->len) {
+        mp_raise_OSError(MP_ENOSPC);
+    }
+    out->total += out->len;
+    out->len = 0;
+}
+
+// Make room for n more bytes (n <= CAPTURE_OUT_MIN)
+static inline uint8_t *out_reserve(capture_out_t *out, size_t n) {
+    if (out->len + n > out->size) {
+        out_flush(out);
+    }
+    return out->buf + out->len;
+}
+
+static void out_bytes(capture_out_t *out, const void *data, size_t n) {
+    const uint8_t *p = data;
+    while (n > 0) {
+        size_t chunk = out->size - out->len;
+        if (chunk == 0) {
+            out_flush(out);
+            continue;
+        }
+        if (chunk > n) {
+            chunk = n;
+        }
+        memcpy(out->buf + out->len, p, chunk);
+        out->len += chunk;
+        p += chunk;
+        n -= chunk;
+    }
+}
+
+// ============================================================================
+// RLE
+// ============================================================================
+
+// Same coding as the frame stream (st7701_stream.h): a control byte c, then
+// (c & 0x7F) + 1 copies of one value if c & 0x80, else c + 1 literal values.
+// Runs don't cross rows.
+static void rle_row(capture_out_t *out, const uint16_t *p, int n) {
+    int i = 0;
+    while (i < n) {
+        int run = 1;
+        while (i + run < n && run < 128 && p[i + run] == p[i]) {
+            run++;
+        }
+        if (run >= 2) {
+            uint8_t *o = out_reserve(out, 3);
+            o[0] = 0x80 | (run - 1);
+            o[1] = p[i] & 0xFF;
+            o[2] = p[i] >> 8;
+            out->len += 3;
+            i += run;
+            continue;
+        }
+
+        // Literals up to the start of the next run
+        int start = i;
+        while (i < n && i - start < 128 && (i + 1 >= n || p[i + 1] != p[i])) {
+            i++;
+        }
+        int count = i - start;
+        uint8_t *o = out_reserve(out, 1 + count * 2);
+        *o++ = count - 1;
+        memcpy(o, p + start, count * 2);
+        out->len += 1 + count * 2;
+    }
+}
+
+// ============================================================================
+// QOI
+// ============================================================================
+
+#define QOI_OP_INDEX    0x00
+#define QOI_OP_DIFF     0x40
+#define QOI_OP_LUMA     0x80
+#define QOI_OP_RUN      0xC0
+#define QOI_OP_RGB      0xFE
+
+typedef struct _qoi_state_t {
+    uint32_t index[64];         // 0xRRGGBB, alpha is always 255
+    uint32_t prev;
+    int run;
+} qoi_state_t;
+
+static inline void qoi_put_be32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void qoi_header(capture_out_t *out, qoi_state_t *q, int w, int h) {
+    uint8_t hdr[14] = { 'q', 'o', 'i', 'f' };
+    qoi_put_be32(hdr + 4, w);
+    qoi_put_be32(hdr + 8, h);
+    hdr[12] = 3;        // RGB
+    hdr[13] = 0;        // sRGB
+    out_bytes(out, hdr, sizeof(hdr));
+
+    memset(q->index, 0xFF, sizeof(q->index));      // never matches an opaque pixel
+    q->prev = 0;
+    q->run = 0;
+}
+
+static void qoi_flush_run(capture_out_t *out, qoi_state_t *q) {
+    if (q->run > 0) {
+        *out_reserve(out, 1) = QOI_OP_RUN | (q->run - 1);
+        out->len++;
+        q->run = 0;
+    }
+}
+
+static void qoi_row(capture_out_t *out, qoi_state_t *q, const uint16_t *p, int n) {
+    for (int i = 0; i < n; i++) {
+        uint16_t c = p[i];
+        uint32_t r = ((c >> 8) & 0xF8) | (c >> 13);
+        uint32_t g = ((c >> 3) & 0xFC) | ((c >> 9) & 0x03);
+        uint32_t b = ((c << 3) & 0xF8) | ((c >> 2) & 0x07);
+        uint32_t px = (r << 16) | (g << 8) | b;
+
+        if (px == q->prev) {
+            if (++q->run == 62) {
+                qoi_flush_run(out, q);
+            }
+            continue;
+        }
+        qoi_flush_run(out, q);
+
+        uint8_t *o = out_reserve(out, 4);
+        int hash = (r * 3 + g * 5 + b * 7 + 255 * 11) & 63;
+        if (q->index[hash] == px) {
+            o[0] = QOI_OP_INDEX | hash;
+            out->len += 1;
+        } else {
+            q->index[hash] = px;
+            int8_t vr = r - (q->prev >> 16);
+            int8_t vg = g - ((q->prev >> 8) & 0xFF);
+            int8_t vb = b - (q->prev & 0xFF);
+            int8_t vg_r = vr - vg;
+            int8_t vg_b = vb - vg;
+            if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                o[0] = QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2);
+                out->len += 1;
+            } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                o[0] = QOI_OP_LUMA | (vg + 32);
+                o[1] = (vg_r + 8) << 4 | (vg_b + 8);
+                out->len += 2;
+            } else {
+                o[0] = QOI_OP_RGB;
+                o[1] = r;
+                o[2] = g;
+                o[3] = b;
+                out->len += 4;
+            }
+        }
+        q->prev = px;
+    }
+}
+
+static void qoi_end(capture_out_t *out, qoi_state_t *q) {
+    static const uint8_t padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    qoi_flush_run(out, q);
+    out_bytes(out, padding, sizeof(padding));
+}
+
+// ============================================================================
+// MicroPython Interface
+// ============================================================================
+
+static void capture_rows(capture_out_t *out, uint16_t *row, int x, int y, int w, int h, int fmt) {
+    qoi_state_t qoi;
+
+    if (fmt == CAPTURE_QOI) {
+        qoi_header(out, &qoi, w, h);
+    } else {
+        uint8_t hdr[8] = { 'S', '7', 'R', 'L', w & 0xFF, w >> 8, h & 0xFF, h >> 8 };
+        if (fmt == CAPTURE_RAW) {
+            out_bytes(out, hdr + 4, 4);
+        } else {
+            out_bytes(out, hdr, 8);
+        }
+    }
+
+    for (int yy = y; yy < y + h; yy++) {
+        st7701_compose_rows(row, yy, 1);
+        switch (fmt) {
+            case CAPTURE_RAW:
+                out_bytes(out, row + x, w * 2);
+                break;
+            case CAPTURE_RLE:
+                rle_row(out, row + x, w);
+                break;
+            default:
+                qoi_row(out, &qoi, row + x, w);
+                break;
+        }
+    }
+
+    if (fmt == CAPTURE_QOI) {
+        qoi_end(out, &qoi);
+    }
+    out_flush(out);
+}
+
+// capture(file, x=0, y=0, w=width, h=height, fmt=CAPTURE_RAW, sync=False) -> bytes written
+// file is a path or a stream opened for binary writing. What is captured is
+// what the panel shows, including overlays and the colour LUT. sync starts
+// at a frame boundary and holds flips until the capture is done.
+static mp_obj_t st7701_capture(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_capture);
+    enum { ARG_self, ARG_file, ARG_x, ARG_y, ARG_w, ARG_h, ARG_fmt, ARG_sync };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_self, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_file, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_x,    MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_y,    MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_w,    MP_ARG_INT, {.u_int = -1} },
+        { MP_QSTR_h,    MP_ARG_INT, {.u_int = -1} },
+        { MP_QSTR_fmt,  MP_ARG_INT, {.u_int = CAPTURE_RAW} },
+        { MP_QSTR_sync, MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    // Works on a windowed display too, so no framebuffer is needed
+    st7701_obj_t *self = MP_OBJ_TO_PTR(args[ARG_self].u_obj);
+    if (self->panel_handle == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Not initialized"));
+    }
+
+    int x = args[ARG_x].u_int;
+    int y = args[ARG_y].u_int;
+    int w = args[ARG_w].u_int < 0 ? self->width - x : args[ARG_w].u_int;
+    int h = args[ARG_h].u_int < 0 ? self->height - y : args[ARG_h].u_int;
+    int fmt = args[ARG_fmt].u_int;
+    if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > self->width || y + h > self->height) {
+        mp_raise_ValueError(MP_ERROR_TEXT("capture area outside the display"));
+    }
+    if (fmt != CAPTURE_RAW && fmt != CAPTURE_RLE && fmt != CAPTURE_QOI) {
+        mp_raise_ValueError(MP_ERROR_TEXT("fmt must be CAPTURE_RAW, CAPTURE_RLE or CAPTURE_QOI"));
+    }
+
+    // Open a path, otherwise write to the stream as given
+    mp_obj_t file = args[ARG_file].u_obj;
+    bool opened = mp_obj_is_str(file);
+    if (opened) {
+        file = mp_call_function_2(MP_OBJ_FROM_PTR(&mp_builtin_open_obj), file, MP_OBJ_NEW_QSTR(MP_QSTR_wb));
+    }
+    mp_get_stream_raise(file, MP_STREAM_OP_WRITE);
+
+    // The row is needed whole, the output buffer can be smaller if the
+    // arena is short
+    capture_out_t out = { .file = file };
+    size_t mark = st7701_scratch_mark();
+    uint16_t *row = st7701_scratch_alloc(self->width * 2, self->width * 2, NULL);
+    out.buf = row != NULL ? st7701_scratch_alloc(CAPTURE_OUT_SIZE, CAPTURE_OUT_MIN, &out.size) : NULL;
+    if (out.buf == NULL) {
+        st7701_scratch_release(mark);
+        if (opened) {
+            mp_stream_close(file);
+        }
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Capture buffer allocation failed"));
+    }
+
+    bool sync = args[ARG_sync].u_bool;
+    if (sync) {
+        st7701_hold_flips(true);
+        st7701_wait_frame(100);
+    }
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        capture_rows(&out, row, x, y, w, h, fmt);
+        nlr_pop();
+    } else {
+        // Write failed - tidy up and re-raise
+        st7701_hold_flips(false);
+        st7701_scratch_release(mark);
+        if (opened) {
+            mp_stream_close(file);
+        }
+        nlr_jump(nlr.ret_val);
+    }
+
+    if (sync) {
+        st7701_hold_flips(false);
+    }
+    st7701_scratch_release(mark);
+    if (opened) {
+        mp_stream_close(file);
+    }
+
+    return mp_obj_new_int_from_uint(out.total);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(st7701_capture_obj, 2, st7701_capture);
@@ -0,0 +1,247 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - stream receiver
+ *
+ * Feeds a frame stream from a host PC (see st7701_stream.h and
+ * utils/stream.py) into the display. Data either comes from Python with
+ * feed(), e.g. read from USB-CDC, or from a UART read by a FreeRTOS task on
+ * the other core so decoding never waits for the interpreter. deinit() of
+ * the display stops any UART receivers bound to it before it lets go of the
+ * framebuffers.
+ */
+
+#include "py/runtime.h"
+#include "py/obj.h"
+
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "st7701.h"
+#include "st7701_stream.h"
+
+static const char *TAG = "ST7701";
+
+#define UART_RX_BUFFER      8192
+#define UART_CHUNK          1024
+#define RECEIVER_STACK      4096
+
+typedef struct _st7701_receiver_obj_t {
+    mp_obj_base_t base;
+    mp_obj_t display;
+    st7701_stream_t stream;
+
+    // UART mode
+    int uart_port;              // -1 when not running
+    TaskHandle_t task;
+    volatile bool running;
+} st7701_receiver_obj_t;
+
+// ============================================================================
+// Stream Target
+// ============================================================================
+
+static uint16_t *target_back_buffer(void *ctx) {
+    return ((st7701_obj_t *)ctx)->framebuffer;
+}
+
+static const uint16_t *target_front_buffer(void *ctx) {
+    return st7701_front_buffer(ctx);
+}
+
+static void target_flip(void *ctx) {
+    st7701_flip(ctx);
+}
+
+// ============================================================================
+// UART Task
+// ============================================================================
+
+// Receivers reading a UART, by port, so deinit() can stop the ones writing
+// into its buffers. Not a GC root: a receiver that is collected is stopped
+// by its finaliser.
+static st7701_receiver_obj_t *uart_receivers[UART_NUM_MAX];
+
+static void receiver_task(void *arg) {
+    st7701_receiver_obj_t *self = arg;
+    uint8_t buf[UART_CHUNK];
+
+    // The display can't go away underneath: deinit() stops this task first
+    while (self->running) {
+        int n = uart_read_bytes(self->uart_port, buf, sizeof(buf), pdMS_TO_TICKS(20));
+        if (n > 0) {
+            ST7701_TRACE_SCOPE(MP_QSTR_feed);
+            st7701_stream_feed(&self->stream, buf, n);
+        }
+    }
+
+    self->task = NULL;
+    vTaskDelete(NULL);
+}
+
+static void receiver_stop(st7701_receiver_obj_t *self) {
+    if (self->uart_port < 0) {
+        return;
+    }
+    self->running = false;
+    // The task notices after its current read and feed. Wait for it to
+    // exit, so nothing is decoding into the display once this returns.
+    while (self->task != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    uart_driver_delete(self->uart_port);
+    uart_receivers[self->uart_port] = NULL;
+    self->uart_port = -1;
+}
+
+void st7701_receivers_stop(st7701_obj_t *display) {
+    for (int i = 0; i < UART_NUM_MAX; i++) {
+        st7701_receiver_obj_t *self = uart_receivers[i];
+        if (self != NULL && MP_OBJ_TO_PTR(self->display) == display) {
+            receiver_stop(self);
+        }
+    }
+}
+
+// ============================================================================
+// MicroPython Interface
+// ============================================================================
+
+// StreamReceiver(display)
+static mp_obj_t receiver_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+
+    if (!mp_obj_is_type(args[0], &st7701_type)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("expected an ST7701 display"));
+    }
+    st7701_obj_t *display = MP_OBJ_TO_PTR(args[0]);
+    st7701_surface_t surface;
+    st7701_get_surface(display, &surface);
+
+    // Finaliser so a running UART task is stopped when the object is collected
+    st7701_receiver_obj_t *self = m_new_obj_with_finaliser(st7701_receiver_obj_t);
+    self->base.type = type;
+    self->display = args[0];
+    self->uart_port = -1;
+    self->task = NULL;
+    self->running = false;
+
+    st7701_stream_target_t target = {
+        .back_buffer = target_back_buffer,
+        .front_buffer = target_front_buffer,
+        .flip = target_flip,
+        .ctx = display,
+        .width = surface.width,
+        .height = surface.height,
+    };
+    st7701_stream_init(&self->stream, &target);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// feed(buf) - decode a chunk of the stream, packets may be split anywhere
+static mp_obj_t receiver_feed(mp_obj_t self_in, mp_obj_t buf_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_feed);
+    st7701_receiver_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if (self->uart_port >= 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("receiver is reading a UART"));
+    }
+    st7701_surface_t surface;
+    st7701_get_surface(MP_OBJ_TO_PTR(self->display), &surface);
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_READ);
+
+    MP_THREAD_GIL_EXIT();
+    st7701_stream_feed(&self->stream, bufinfo.buf, bufinfo.len);
+    MP_THREAD_GIL_ENTER();
+
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(receiver_feed_obj, receiver_feed);
+
+// uart(port, baudrate, rx, tx=-1) - receive from a UART in the background
+static mp_obj_t receiver_uart(size_t n_args, const mp_obj_t *args) {
+    st7701_receiver_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t port = mp_obj_get_int(args[1]);
+    mp_int_t baudrate = mp_obj_get_int(args[2]);
+    mp_int_t rx = mp_obj_get_int(args[3]);
+    mp_int_t tx = n_args > 4 ? mp_obj_get_int(args[4]) : UART_PIN_NO_CHANGE;
+
+    if (port < 0 || port >= UART_NUM_MAX) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid UART port"));
+    }
+    receiver_stop(self);
+
+    // Raises if the display isn't initialised
+    st7701_surface_t surface;
+    st7701_get_surface(MP_OBJ_TO_PTR(self->display), &surface);
+
+    uart_config_t config = {
+        .baud_rate = baudrate,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    if (uart_driver_install(port, UART_RX_BUFFER, 0, 0, NULL, 0) != ESP_OK) {
+        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("UART in use"));
+    }
+    uart_param_config(port, &config);
+    uart_set_pin(port, tx, rx, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+
+    self->uart_port = port;
+    self->running = true;
+    uart_receivers[port] = self;
+    // MicroPython runs on core 1, so decode on core 0
+    if (xTaskCreatePinnedToCore(receiver_task, "st7701_rx", RECEIVER_STACK, self, 5, &self->task, 0) != pdPASS) {
+        self->running = false;
+        self->task = NULL;
+        receiver_stop(self);
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Failed to start receiver task"));
+    }
+    ESP_LOGI(TAG, "Stream receiver on UART%d at %d baud", (int)port, (int)baudrate);
+
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(receiver_uart_obj, 4, 5, receiver_uart);
+
+// stop() - stop receiving from the UART
+static mp_obj_t receiver_stop_method(mp_obj_t self_in) {
+    receiver_stop(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(receiver_stop_obj, receiver_stop_method);
+
+// stats() -> (frames, rects, bytes, errors)
+static mp_obj_t receiver_stats(mp_obj_t self_in) {
+    st7701_receiver_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    st7701_stream_stats_t *st = &self->stream.stats;
+    mp_obj_t items[4] = {
+        mp_obj_new_int_from_uint(st->frames),
+        mp_obj_new_int_from_uint(st->rects),
+        mp_obj_new_int_from_uint(st->bytes),
+        mp_obj_new_int_from_uint(st->errors),
+    };
+    return mp_obj_new_tuple(4, items);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(receiver_stats_obj, receiver_stats);
+
+static const mp_rom_map_elem_t receiver_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_feed),        MP_ROM_PTR(&receiver_feed_obj) },
+    { MP_ROM_QSTR(MP_QSTR_uart),        MP_ROM_PTR(&receiver_uart_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop),        MP_ROM_PTR(&receiver_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats),       MP_ROM_PTR(&receiver_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__),     MP_ROM_PTR(&receiver_stop_obj) },
+};
+static MP_DEFINE_CONST_DICT(receiver_locals_dict, receiver_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    st7701_stream_receiver_type,
+    MP_QSTR_StreamReceiver,
+    MP_TYPE_FLAG_NONE,
+    make_new, receiver_make_new,
+    locals_dict, &receiver_locals_dict
+);
@@ -0,0 +1,763 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - tile layer and sprite engine
+ *
+ * A Scene is one tile layer (an RGB565 tile sheet plus a map of tile
+ * indices, with scroll offsets) and a z-ordered list of colour-keyed
+ * sprites. render() only repaints the screen cells that changed since the
+ * last render: cells under sprites that moved, tiles that were changed and
+ * the strips exposed by scrolling. With double buffering each buffer also
+ * catches up with the cells the renders into the other one changed.
+ *
+ * Sprite positions and the scroll offset can also be animated (see
+ * st7701_anim.c): render() steps them to where they should be at the start
+ * of the current frame before working out what changed.
+ */
+
+#include "py/runtime.h"
+#include "py/obj.h"
+
+#include "st7701.h"
+
+#define SCENE_MAX_SPRITES   32
+#define SCENE_BUFFERS       2
+
+typedef struct _scene_sprite_t {
+    mp_obj_t buf_obj;           // keeps the pixels alive, mp_const_none if unused
+    const uint16_t *pixels;
+    uint16_t w;
+    uint16_t h;
+    int32_t key;                // transparent colour, -1 for none
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    bool visible;
+    bool changed;               // pixels replaced since the last render
+    st7701_tween_t tween;       // position animation
+
+    // Where the sprite was drawn by the last render
+    int16_t drawn_x;
+    int16_t drawn_y;
+    uint16_t drawn_w;
+    uint16_t drawn_h;
+    bool drawn;
+} scene_sprite_t;
+
+// A framebuffer render() has drawn into
+typedef struct _scene_buffer_t {
+    const uint16_t *pixels;     // NULL until first drawn into
+    int scroll_x;               // scroll offset it shows
+    int scroll_y;
+    uint32_t *behind;           // cells it has to repaint, relative to its own scroll
+} scene_buffer_t;
+
+typedef struct _st7701_scene_obj_t {
+    mp_obj_base_t base;
+    mp_obj_t display;
+
+    // Tile sheet
+    mp_obj_t sheet_obj;
+    const uint16_t *sheet;
+    int sheet_w;                // in pixels
+    int sheet_cols;             // in tiles
+    int tile_count;
+    int tile_w;
+    int tile_h;
+
+    // Tile map
+    mp_obj_t map_obj;
+    void *map;
+    bool map16;                 // 16-bit indices ('H' array), otherwise 8-bit
+    int map_w;                  // in tiles
+    int map_h;
+
+    // Scroll offset requested, and the one the last render drew at, which
+    // sprites' drawn positions are relative to
+    int scroll_x;
+    int scroll_y;
+    int drawn_scroll_x;
+    int drawn_scroll_y;
+    st7701_tween_t scroll_tween;
+
+    // Buffers renders have gone to - with double buffering render() gets
+    // them in turn, each a frame behind the one last drawn. What a render
+    // changes is added to the other buffer's cells to repaint.
+    scene_buffer_t buffers[SCENE_BUFFERS];
+    int last_buffer;
+
+    // One bit per screen cell (tile sized, aligned to the screen) for what
+    // the current render changed
+    uint32_t *dirty;
+    uint32_t *shift;            // scratch for scene_shift_cells(), the same size
+    int cells_x;
+    int cells_y;
+
+    scene_sprite_t sprites[SCENE_MAX_SPRITES];
+    uint8_t order[SCENE_MAX_SPRITES];   // sprite ids sorted by z
+
+    // Stats for the last render
+    uint32_t repainted_px;
+    uint32_t shifted_px;
+    uint32_t dirty_cells;
+} st7701_scene_obj_t;
+
+// ============================================================================
+// Dirty Tracking
+// ============================================================================
+
+static void scene_mark_cells(st7701_scene_obj_t *self, uint32_t *bits, int x, int y, int w, int h) {
+    if (w <= 0 || h <= 0 || x + w <= 0 || y + h <= 0) {
+        return;
+    }
+    int cx0 = x > 0 ? x / self->tile_w : 0;
+    int cy0 = y > 0 ? y / self->tile_h : 0;
+    int cx1 = (x + w - 1) / self->tile_w;
+    int cy1 = (y + h - 1) / self->tile_h;
+    if (cx1 >= self->cells_x) cx1 = self->cells_x - 1;
+    if (cy1 >= self->cells_y) cy1 = self->cells_y - 1;
+
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            int bit = cy * self->cells_x + cx;
+            bits[bit >> 5] |= 1u << (bit & 31);
+        }
+    }
+}
+
+static inline void scene_mark_dirty(st7701_scene_obj_t *self, int x, int y, int w, int h) {
+    scene_mark_cells(self, self->dirty, x, y, w, h);
+}
+
+static inline bool scene_is_dirty(const st7701_scene_obj_t *self, int cx, int cy) {
+    int bit = cy * self->cells_x + cx;
+    return (self->dirty[bit >> 5] >> (bit & 31)) & 1;
+}
+
+static size_t scene_dirty_words(const st7701_scene_obj_t *self) {
+    return (self->cells_x * self->cells_y + 31) / 32;
+}
+
+// Move every cell marked in bits by (-dx, -dy), for a change of scroll
+static void scene_shift_cells(st7701_scene_obj_t *self, uint32_t *bits, int dx, int dy) {
+    size_t words = scene_dirty_words(self);
+    uint32_t *old = self->shift;
+    memcpy(old, bits, words * 4);
+    memset(bits, 0, words * 4);
+
+    for (int cy = 0; cy < self->cells_y; cy++) {
+        for (int cx = 0; cx < self->cells_x; cx++) {
+            int bit = cy * self->cells_x + cx;
+            if ((old[bit >> 5] >> (bit & 31)) & 1) {
+                scene_mark_cells(self, bits, cx * self->tile_w - dx, cy * self->tile_h - dy,
+                                 self->tile_w, self->tile_h);
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Rendering
+// ============================================================================
+
+static inline int wrap(int v, int n) {
+    v %= n;
+    return v < 0 ? v + n : v;
+}
+
+static int scene_tile_at(const st7701_scene_obj_t *self, int col, int row) {
+    int i = row * self->map_w + col;
+    int tile = self->map16 ? ((const uint16_t *)self->map)[i] : ((const uint8_t *)self->map)[i];
+    return tile < self->tile_count ? tile : 0;
+}
+
+// Repaint the tile layer in a screen rectangle
+static void scene_draw_tiles(st7701_scene_obj_t *self, const st7701_surface_t *s,
+                             int x0, int y0, int x1, int y1) {
+    int map_px_w = self->map_w * self->tile_w;
+    int map_px_h = self->map_h * self->tile_h;
+
+    for (int y = y0; y < y1; y++) {
+        int my = wrap(y + self->scroll_y, map_px_h);
+        int row = my / self->tile_h;
+        int ty = my % self->tile_h;
+        uint16_t *out = s->pixels + y * s->stride;
+
+        int x = x0;
+        while (x < x1) {
+            int mx = wrap(x + self->scroll_x, map_px_w);
+            int tx = mx % self->tile_w;
+            int tile = scene_tile_at(self, mx / self->tile_w, row);
+            int n = self->tile_w - tx;
+            if (n > x1 - x) {
+                n = x1 - x;
+            }
+            const uint16_t *src = self->sheet +
+                ((tile / self->sheet_cols) * self->tile_h + ty) * self->sheet_w +
+                (tile % self->sheet_cols) * self->tile_w + tx;
+            memcpy(out + x, src, n * 2);
+            x += n;
+        }
+    }
+}
+
+// Composite every visible sprite, in z order, over a screen rectangle
+static void scene_draw_sprites(st7701_scene_obj_t *self, const st7701_surface_t *s,
+                               int x0, int y0, int x1, int y1) {
+    for (int i = 0; i < SCENE_MAX_SPRITES; i++) {
+        const scene_sprite_t *sp = &self->sprites[self->order[i]];
+        if (!sp->visible || sp->pixels == NULL) {
+            continue;
+        }
+        int sx0 = sp->x > x0 ? sp->x : x0;
+        int sy0 = sp->y > y0 ? sp->y : y0;
+        int sx1 = sp->x + sp->w < x1 ? sp->x + sp->w : x1;
+        int sy1 = sp->y + sp->h < y1 ? sp->y + sp->h : y1;
+        if (sx0 >= sx1 || sy0 >= sy1) {
+            continue;
+        }
+
+        for (int y = sy0; y < sy1; y++) {
+            uint16_t *out = s->pixels + y * s->stride + sx0;
+            const uint16_t *src = sp->pixels + (y - sp->y) * sp->w + (sx0 - sp->x);
+            int n = sx1 - sx0;
+            if (sp->key < 0) {
+                memcpy(out, src, n * 2);
+            } else {
+                uint16_t key = sp->key;
+                for (int j = 0; j < n; j++) {
+                    if (src[j] != key) {
+                        out[j] = src[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Shift the framebuffer so its content moves by (-dx, -dy)
+static void scene_shift_framebuffer(const st7701_surface_t *s, int dx, int dy) {
+    int w = s->width - (dx < 0 ? -dx : dx);
+    int dst_x = dx < 0 ? -dx : 0;
+    int src_x = dx < 0 ? 0 : dx;
+
+    if (dy >= 0) {
+        for (int y = 0; y < s->height - dy; y++) {
+            memmove(s->pixels + y * s->stride + dst_x, s->pixels + (y + dy) * s->stride + src_x, w * 2);
+        }
+    } else {
+        for (int y = s->height - 1; y >= -dy; y--) {
+            memmove(s->pixels + y * s->stride + dst_x, s->pixels + (y + dy) * s->stride + src_x, w * 2);
+        }
+    }
+}
+
+// Bring a buffer up to the requested scroll offset. It moves by how far
+// it is behind, which with double buffering is two renders' scrolling.
+static void scene_apply_scroll(st7701_scene_obj_t *self, const st7701_surface_t *s, scene_buffer_t *buf) {
+    // Sprites' drawn positions follow the scroll of the last render
+    int dx = self->scroll_x - self->drawn_scroll_x;
+    int dy = self->scroll_y - self->drawn_scroll_y;
+    self->drawn_scroll_x = self->scroll_x;
+    self->drawn_scroll_y = self->scroll_y;
+    for (int i = 0; i < SCENE_MAX_SPRITES; i++) {
+        scene_sprite_t *sp = &self->sprites[i];
+        if (sp->drawn) {
+            sp->drawn_x -= dx;
+            sp->drawn_y -= dy;
+        }
+    }
+
+    int bx = self->scroll_x - buf->scroll_x;
+    int by = self->scroll_y - buf->scroll_y;
+    if (bx == 0 && by == 0) {
+        return;
+    }
+    buf->scroll_x = self->scroll_x;
+    buf->scroll_y = self->scroll_y;
+    if (bx <= -s->width || bx >= s->width || by <= -s->height || by >= s->height) {
+        memset(buf->behind, 0xFF, scene_dirty_words(self) * 4);
+        return;
+    }
+
+    // Reuse what's already on screen and only repaint the exposed strips
+    scene_shift_framebuffer(s, bx, by);
+    self->shifted_px += (s->width - (bx < 0 ? -bx : bx)) * (s->height - (by < 0 ? -by : by));
+    scene_shift_cells(self, buf->behind, bx, by);
+
+    if (bx > 0) {
+        scene_mark_cells(self, buf->behind, s->width - bx, 0, bx, s->height);
+    } else if (bx < 0) {
+        scene_mark_cells(self, buf->behind, 0, 0, -bx, s->height);
+    }
+    if (by > 0) {
+        scene_mark_cells(self, buf->behind, 0, s->height - by, s->width, by);
+    } else if (by < 0) {
+        scene_mark_cells(self, buf->behind, 0, 0, s->width, -by);
+    }
+}
+
+// Buffer for the framebuffer at pixels. One not seen before has unknown
+// contents, so it is repainted in full.
+static scene_buffer_t *scene_buffer(st7701_scene_obj_t *self, const uint16_t *pixels) {
+    for (int i = 0; i < SCENE_BUFFERS; i++) {
+        if (self->buffers[i].pixels == pixels) {
+            self->last_buffer = i;
+            return &self->buffers[i];
+        }
+    }
+    self->last_buffer = (self->last_buffer + 1) % SCENE_BUFFERS;
+    scene_buffer_t *buf = &self->buffers[self->last_buffer];
+    buf->pixels = pixels;
+    buf->scroll_x = self->scroll_x;
+    buf->scroll_y = self->scroll_y;
+    memset(buf->behind, 0xFF, scene_dirty_words(self) * 4);
+    return buf;
+}
+
+// Add the cells changed by this render (relative to the current scroll) to
+// the other buffers' cells to repaint, relative to their own scroll
+static void scene_share_changes(st7701_scene_obj_t *self, const scene_buffer_t *drawn) {
+    for (int i = 0; i < SCENE_BUFFERS; i++) {
+        scene_buffer_t *buf = &self->buffers[i];
+        if (buf == drawn || buf->pixels == NULL) {
+            continue;
+        }
+        int dx = self->scroll_x - buf->scroll_x;
+        int dy = self->scroll_y - buf->scroll_y;
+        for (int cy = 0; cy < self->cells_y; cy++) {
+            for (int cx = 0; cx < self->cells_x; cx++) {
+                if (scene_is_dirty(self, cx, cy)) {
+                    scene_mark_cells(self, buf->behind, cx * self->tile_w + dx, cy * self->tile_h + dy,
+                                     self->tile_w, self->tile_h);
+                }
+            }
+        }
+    }
+}
+
+// Mark the old and new rectangles of every sprite that changed
+static void scene_track_sprites(st7701_scene_obj_t *self) {
+    for (int i = 0; i < SCENE_MAX_SPRITES; i++) {
+        scene_sprite_t *sp = &self->sprites[i];
+        bool show = sp->visible && sp->pixels != NULL;
+        if (!sp->changed && show == sp->drawn && (!show || (sp->x == sp->drawn_x && sp->y == sp->drawn_y))) {
+            continue;
+        }
+        if (sp->drawn) {
+            scene_mark_dirty(self, sp->drawn_x, sp->drawn_y, sp->drawn_w, sp->drawn_h);
+        }
+        if (show) {
+            scene_mark_dirty(self, sp->x, sp->y, sp->w, sp->h);
+        }
+        sp->drawn = show;
+        sp->drawn_x = sp->x;
+        sp->drawn_y = sp->y;
+        sp->drawn_w = sp->w;
+        sp->drawn_h = sp->h;
+        sp->changed = false;
+    }
+}
+
+// Step running animations to the start of the current frame
+static void scene_animate(st7701_scene_obj_t *self) {
+    uint32_t now_us = st7701_frame_start_us();
+    int32_t v[2];
+    if (self->scroll_tween.active) {
+        st7701_tween_step(&self->scroll_tween, now_us, v);
+        self->scroll_x = v[0];
+        self->scroll_y = v[1];
+    }
+    for (int i = 0; i < SCENE_MAX_SPRITES; i++) {
+        scene_sprite_t *sp = &self->sprites[i];
+        if (sp->tween.active) {
+            st7701_tween_step(&sp->tween, now_us, v);
+            sp->x = v[0];
+            sp->y = v[1];
+        }
+    }
+}
+
+static uint32_t scene_render(st7701_scene_obj_t *self) {
+    st7701_surface_t s;
+    st7701_get_surface(MP_OBJ_TO_PTR(self->display), &s);
+    scene_buffer_t *buf = scene_buffer(self, s.pixels);
+
+    self->repainted_px = 0;
+    self->shifted_px = 0;
+    self->dirty_cells = 0;
+
+    scene_animate(self);
+    scene_apply_scroll(self, &s, buf);
+    scene_track_sprites(self);
+
+    // What changed also has to reach the other buffer; this one repaints
+    // that plus whatever it was behind by
+    scene_share_changes(self, buf);
+    size_t words = scene_dirty_words(self);
+    for (size_t i = 0; i < words; i++) {
+        self->dirty[i] |= buf->behind[i];
+    }
+
+    // Repaint runs of dirty cells along each row of cells
+    for (int cy = 0; cy < self->cells_y; cy++) {
+        int y0 = cy * self->tile_h;
+        int y1 = y0 + self->tile_h < s.height ? y0 + self->tile_h : s.height;
+        int cx = 0;
+        while (cx < self->cells_x) {
+            if (!scene_is_dirty(self, cx, cy)) {
+                cx++;
+                continue;
+            }
+            int run = cx;
+            while (run < self->cells_x && scene_is_dirty(self, run, cy)) {
+                run++;
+            }
+            int x0 = cx * self->tile_w;
+            int x1 = run * self->tile_w < s.width ? run * self->tile_w : s.width;
+
+            scene_draw_tiles(self, &s, x0, y0, x1, y1);
+            scene_draw_sprites(self, &s, x0, y0, x1, y1);
+
+            self->repainted_px += (x1 - x0) * (y1 - y0);
+            self->dirty_cells += run - cx;
+            cx = run;
+        }
+    }
+    memset(buf->behind, 0, words * 4);
+    memset(self->dirty, 0, words * 4);
+
+    return self->repainted_px + self->shifted_px;
+}
+
+// Keep order[] sorted by z, stable on sprite id
+static void scene_sort(st7701_scene_obj_t *self) {
+    for (int i = 1; i < SCENE_MAX_SPRITES; i++) {
+        uint8_t id = self->order[i];
+        int j = i - 1;
+        while (j >= 0 && self->sprites[self->order[j]].z > self->sprites[id].z) {
+            self->order[j + 1] = self->order[j];
+            j--;
+        }
+        self->order[j + 1] = id;
+    }
+}
+
+// ============================================================================
+// MicroPython Interface
+// ============================================================================
+
+static const void *get_buffer(mp_obj_t obj, size_t min_len, mp_buffer_info_t *bufinfo) {
+    mp_get_buffer_raise(obj, bufinfo, MP_BUFFER_READ);
+    if (bufinfo->len < min_len) {
+        mp_raise_ValueError(MP_ERROR_TEXT("buffer too small for dimensions"));
+    }
+    return bufinfo->buf;
+}
+
+// Scene(display, sheet, sheet_w, tile_w, tile_h, map, map_w, map_h)
+// sheet is RGB565, sheet_w its width in pixels. map is a bytearray or an
+// array('H') of tile indices, map_w x map_h tiles.
+static mp_obj_t st7701_scene_make_new(const mp_obj_type_t *type, size_t n_args,
+                                      size_t n_kw, const mp_obj_t *all_args) {
+    enum { ARG_display, ARG_sheet, ARG_sheet_w, ARG_tile_w, ARG_tile_h, ARG_map, ARG_map_w, ARG_map_h };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_display, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_sheet,   MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_sheet_w, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_tile_w,  MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_tile_h,  MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_map,     MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_map_w,   MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_map_h,   MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (!mp_obj_is_type(args[ARG_display].u_obj, &st7701_type)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("expected an ST7701"));
+    }
+    st7701_obj_t *display = MP_OBJ_TO_PTR(args[ARG_display].u_obj);
+
+    int sheet_w = args[ARG_sheet_w].u_int;
+    int tile_w = args[ARG_tile_w].u_int;
+    int tile_h = args[ARG_tile_h].u_int;
+    int map_w = args[ARG_map_w].u_int;
+    int map_h = args[ARG_map_h].u_int;
+    if (tile_w <= 0 || tile_h <= 0 || sheet_w < tile_w || map_w <= 0 || map_h <= 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid tile or map size"));
+    }
+
+    st7701_scene_obj_t *self = mp_obj_malloc(st7701_scene_obj_t, type);
+    memset(self, 0, sizeof(*self));
+    self->base.type = type;
+    self->display = args[ARG_display].u_obj;
+
+    mp_buffer_info_t bufinfo;
+    self->sheet_obj = args[ARG_sheet].u_obj;
+    self->sheet = get_buffer(self->sheet_obj, sheet_w * tile_h * 2, &bufinfo);
+    self->sheet_w = sheet_w;
+    self->sheet_cols = sheet_w / tile_w;
+    self->tile_count = self->sheet_cols * (bufinfo.len / 2 / sheet_w / tile_h);
+    self->tile_w = tile_w;
+    self->tile_h = tile_h;
+
+    self->map_obj = args[ARG_map].u_obj;
+    mp_get_buffer_raise(self->map_obj, &bufinfo, MP_BUFFER_READ);
+    self->map16 = bufinfo.typecode == 'H';
+    if (bufinfo.len < (size_t)(map_w * map_h * (self->map16 ? 2 : 1))) {
+        mp_raise_ValueError(MP_ERROR_TEXT("map too small for dimensions"));
+    }
+    self->map = bufinfo.buf;
+    self->map_w = map_w;
+    self->map_h = map_h;
+
+    self->cells_x = (display->width + tile_w - 1) / tile_w;
+    self->cells_y = (display->height + tile_h - 1) / tile_h;
+    self->dirty = m_new0(uint32_t, scene_dirty_words(self));
+    self->shift = m_new0(uint32_t, scene_dirty_words(self));
+    for (int i = 0; i < SCENE_BUFFERS; i++) {
+        self->buffers[i].behind = m_new0(uint32_t, scene_dirty_words(self));
+    }
+
+    for (int i = 0; i < SCENE_MAX_SPRITES; i++) {
+        self->sprites[i].buf_obj = mp_const_none;
+        self->order[i] = i;
+    }
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+static scene_sprite_t *get_sprite(st7701_scene_obj_t *self, mp_obj_t id_in) {
+    mp_int_t id = mp_obj_get_int(id_in);
+    if (id < 0 || id >= SCENE_MAX_SPRITES) {
+        mp_raise_ValueError(MP_ERROR_TEXT("sprite id out of range"));
+    }
+    return &self->sprites[id];
+}
+
+// scroll(x, y) - map pixel shown at the top-left of the screen (wraps)
+static mp_obj_t st7701_scene_scroll(mp_obj_t self_in, mp_obj_t x_in, mp_obj_t y_in) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    self->scroll_tween.active = false;
+    self->scroll_x = mp_obj_get_int(x_in);
+    self->scroll_y = mp_obj_get_int(y_in);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(st7701_scene_scroll_obj, st7701_scene_scroll);
+
+// set_tile(col, row, index) - change one map entry and repaint it on the next render
+static mp_obj_t st7701_scene_set_tile(size_t n_args, const mp_obj_t *args) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t col = mp_obj_get_int(args[1]);
+    mp_int_t row = mp_obj_get_int(args[2]);
+    mp_int_t tile = mp_obj_get_int(args[3]);
+    if (col < 0 || col >= self->map_w || row < 0 || row >= self->map_h) {
+        mp_raise_ValueError(MP_ERROR_TEXT("tile position out of range"));
+    }
+
+    int i = row * self->map_w + col;
+    if (self->map16) {
+        ((uint16_t *)self->map)[i] = tile;
+    } else {
+        ((uint8_t *)self->map)[i] = tile;
+    }
+
+    // Mark every place the tile appears in each buffer (the map may wrap)
+    int map_px_w = self->map_w * self->tile_w;
+    int map_px_h = self->map_h * self->tile_h;
+    st7701_obj_t *display = MP_OBJ_TO_PTR(self->display);
+    for (int b = 0; b < SCENE_BUFFERS; b++) {
+        scene_buffer_t *buf = &self->buffers[b];
+        if (buf->pixels == NULL) {
+            continue;
+        }
+        int x0 = col * self->tile_w - wrap(buf->scroll_x, map_px_w);
+        int y0 = row * self->tile_h - wrap(buf->scroll_y, map_px_h);
+        for (int y = y0 - map_px_h; y < display->height; y += map_px_h) {
+            for (int x = x0 - map_px_w; x < display->width; x += map_px_w) {
+                scene_mark_cells(self, buf->behind, x, y, self->tile_w, self->tile_h);
+            }
+        }
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_scene_set_tile_obj, 4, 4, st7701_scene_set_tile);
+
+// sprite(id, buffer, w, h, [key]) - define a sprite, sprite(id, None) removes it
+static mp_obj_t st7701_scene_sprite(size_t n_args, const mp_obj_t *args) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    scene_sprite_t *sp = get_sprite(self, args[1]);
+
+    if (args[2] == mp_const_none) {
+        sp->buf_obj = mp_const_none;
+        sp->pixels = NULL;
+        sp->changed = true;
+        sp->tween.active = false;
+        return mp_const_none;
+    }
+    if (n_args < 5) {
+        mp_raise_TypeError(MP_ERROR_TEXT("sprite needs buffer, w and h"));
+    }
+
+    mp_int_t w = mp_obj_get_int(args[3]);
+    mp_int_t h = mp_obj_get_int(args[4]);
+    if (w <= 0 || h <= 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid sprite size"));
+    }
+    mp_buffer_info_t bufinfo;
+    const uint16_t *pixels = get_buffer(args[2], w * h * 2, &bufinfo);
+
+    if (sp->pixels == NULL) {
+        sp->visible = true;
+    }
+    sp->buf_obj = args[2];
+    sp->pixels = pixels;
+    sp->w = w;
+    sp->h = h;
+    sp->key = n_args > 5 ? mp_obj_get_int(args[5]) : -1;
+    sp->changed = true;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_scene_sprite_obj, 3, 6, st7701_scene_sprite);
+
+// move(id, x, y)
+static mp_obj_t st7701_scene_move(size_t n_args, const mp_obj_t *args) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    scene_sprite_t *sp = get_sprite(self, args[1]);
+    sp->tween.active = false;
+    sp->x = mp_obj_get_int(args[2]);
+    sp->y = mp_obj_get_int(args[3]);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_scene_move_obj, 4, 4, st7701_scene_move);
+
+// z(id, z) - higher z is drawn on top, equal z in id order
+static mp_obj_t st7701_scene_z(mp_obj_t self_in, mp_obj_t id_in, mp_obj_t z_in) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    scene_sprite_t *sp = get_sprite(self, id_in);
+    sp->z = mp_obj_get_int(z_in);
+    sp->changed = true;
+    scene_sort(self);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(st7701_scene_z_obj, st7701_scene_z);
+
+// show(id, on)
+static mp_obj_t st7701_scene_show(mp_obj_t self_in, mp_obj_t id_in, mp_obj_t on_in) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    get_sprite(self, id_in)->visible = mp_obj_is_true(on_in);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(st7701_scene_show_obj, st7701_scene_show);
+
+// animate(id, prop, to, duration_ms, ease=EASE_IN_OUT, *, delay_ms=0, repeat=0, yoyo=False)
+// Animate a sprite's position (id, ANIM_POS) or the scroll offset
+// (None, ANIM_SCROLL) to to, an (x, y) tuple, from where it is now. Each
+// render() moves it on to where it should be at the start of that frame.
+// move() and scroll() stop it.
+static mp_obj_t st7701_scene_animate(size_t n_args, const mp_obj_t *args, mp_map_t *kw_args) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t prop = mp_obj_get_int(args[2]);
+    st7701_tween_t *tw;
+    int32_t from[2];
+    if (prop == ANIM_SCROLL && args[1] == mp_const_none) {
+        tw = &self->scroll_tween;
+        from[0] = self->scroll_x;
+        from[1] = self->scroll_y;
+    } else if (prop == ANIM_POS && args[1] != mp_const_none) {
+        scene_sprite_t *sp = get_sprite(self, args[1]);
+        tw = &sp->tween;
+        from[0] = sp->x;
+        from[1] = sp->y;
+    } else {
+        mp_raise_ValueError(MP_ERROR_TEXT("Scene animates ANIM_POS of a sprite or ANIM_SCROLL of None"));
+    }
+    st7701_tween_parse(tw, from, 2, n_args - 3, args + 3, kw_args);
+    tw->active = true;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(st7701_scene_animate_obj, 3, st7701_scene_animate);
+
+// animating([id]) -> number of animations running, on one sprite (None for
+// the scroll) or in the whole scene
+static mp_obj_t st7701_scene_animating(size_t n_args, const mp_obj_t *args) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (n_args > 1) {
+        if (args[1] == mp_const_none) {
+            return mp_obj_new_int(self->scroll_tween.active);
+        }
+        return mp_obj_new_int(get_sprite(self, args[1])->tween.active);
+    }
+    int count = self->scroll_tween.active;
+    for (int i = 0; i < SCENE_MAX_SPRITES; i++) {
+        count += self->sprites[i].tween.active;
+    }
+    return mp_obj_new_int(count);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_scene_animating_obj, 1, 2, st7701_scene_animating);
+
+// stop_animation(id) - stop a sprite's animation (None for the scroll),
+// leaving it where it got to
+static mp_obj_t st7701_scene_stop_animation(mp_obj_t self_in, mp_obj_t id_in) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (id_in == mp_const_none) {
+        self->scroll_tween.active = false;
+    } else {
+        get_sprite(self, id_in)->tween.active = false;
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(st7701_scene_stop_animation_obj, st7701_scene_stop_animation);
+
+// invalidate() - repaint everything on the next render
+static mp_obj_t st7701_scene_invalidate(mp_obj_t self_in) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    for (int i = 0; i < SCENE_BUFFERS; i++) {
+        memset(self->buffers[i].behind, 0xFF, scene_dirty_words(self) * 4);
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_scene_invalidate_obj, st7701_scene_invalidate);
+
+// render() -> pixels touched (repainted + shifted by scrolling)
+static mp_obj_t st7701_scene_render(mp_obj_t self_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_render);
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int(scene_render(self));
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_scene_render_obj, st7701_scene_render);
+
+// stats() -> (repainted_px, shifted_px, dirty_cells) for the last render
+static mp_obj_t st7701_scene_stats(mp_obj_t self_in) {
+    st7701_scene_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t tuple[3] = {
+        mp_obj_new_int(self->repainted_px),
+        mp_obj_new_int(self->shifted_px),
+        mp_obj_new_int(self->dirty_cells),
+    };
+    return mp_obj_new_tuple(3, tuple);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_scene_stats_obj, st7701_scene_stats);
+
+static const mp_rom_map_elem_t st7701_scene_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_scroll),      MP_ROM_PTR(&st7701_scene_scroll_obj) },
+    { MP_ROM_QSTR(MP_QSTR_set_tile),    MP_ROM_PTR(&st7701_scene_set_tile_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sprite),      MP_ROM_PTR(&st7701_scene_sprite_obj) },
+    { MP_ROM_QSTR(MP_QSTR_move),        MP_ROM_PTR(&st7701_scene_move_obj) },
+    { MP_ROM_QSTR(MP_QSTR_z),           MP_ROM_PTR(&st7701_scene_z_obj) },
+    { MP_ROM_QSTR(MP_QSTR_show),        MP_ROM_PTR(&st7701_scene_show_obj) },
+    { MP_ROM_QSTR(MP_QSTR_animate),     MP_ROM_PTR(&st7701_scene_animate_obj) },
+    { MP_ROM_QSTR(MP_QSTR_animating),   MP_ROM_PTR(&st7701_scene_animating_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop_animation), MP_ROM_PTR(&st7701_scene_stop_animation_obj) },
+    { MP_ROM_QSTR(MP_QSTR_invalidate),  MP_ROM_PTR(&st7701_scene_invalidate_obj) },
+    { MP_ROM_QSTR(MP_QSTR_render),      MP_ROM_PTR(&st7701_scene_render_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats),       MP_ROM_PTR(&st7701_scene_stats_obj) },
+};
+static MP_DEFINE_CONST_DICT(st7701_scene_locals_dict, st7701_scene_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    st7701_scene_type,
+    MP_QSTR_Scene,
+    MP_TYPE_FLAG_NONE,
+    make_new, st7701_scene_make_new,
+    locals_dict, &st7701_scene_locals_dict
+);
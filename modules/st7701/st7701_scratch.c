@@ -0,0 +1,136 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - scratch arena
+ *
+ * One block of DMA-capable internal SRAM that the pixel kernels - rotate(),
+ * rotated and scaled assets, capture() - take their row and tile staging
+ * buffers from, instead of working in place in PSRAM or going to the heap
+ * on every call. Allocation is a stack: a kernel takes a mark, allocates,
+ * and releases back to the mark before it returns.
+ *
+ * A kernel asks for the size it would like and the least it can work with,
+ * and gets whatever fits in between, so when the arena is small or busy it
+ * carries on with smaller tiles, or its slower path, rather than failing.
+ *
+ * Only used from the MicroPython task.
+ */
+
+#include "py/runtime.h"
+#include "py/obj.h"
+
+#include "esp_heap_caps.h"
+
+#include "st7701.h"
+
+#define SCRATCH_DEFAULT_SIZE    (32 * 1024)
+#define SCRATCH_MAX_SIZE        (256 * 1024)
+#define SCRATCH_ALIGN           4           // DMA needs word alignment
+
+typedef struct _scratch_state_t {
+    uint8_t *base;          // allocated on first use
+    size_t size;
+    size_t top;
+    size_t high;            // high-water mark of top
+    uint32_t allocs;
+    uint32_t shorts;        // given less than asked for
+    uint32_t fails;         // couldn't give the minimum
+} scratch_state_t;
+
+static scratch_state_t scratch = { .size = SCRATCH_DEFAULT_SIZE };
+
+static void scratch_stats_reset(void) {
+    scratch.high = scratch.top;
+    scratch.allocs = 0;
+    scratch.shorts = 0;
+    scratch.fails = 0;
+}
+
+size_t st7701_scratch_mark(void) {
+    return scratch.top;
+}
+
+void st7701_scratch_release(size_t mark) {
+    if (mark < scratch.top) {
+        scratch.top = mark;
+    }
+}
+
+void *st7701_scratch_alloc(size_t want, size_t min, size_t *got) {
+    scratch.allocs++;
+    if (scratch.base == NULL && scratch.size > 0) {
+        scratch.base = heap_caps_malloc(scratch.size, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+    }
+    size_t top = (scratch.top + SCRATCH_ALIGN - 1) & ~(size_t)(SCRATCH_ALIGN - 1);
+    size_t avail = scratch.base != NULL && top < scratch.size ? scratch.size - top : 0;
+    if (avail < min || avail == 0) {
+        scratch.fails++;
+        return NULL;
+    }
+    size_t n = want;
+    if (n > avail) {
+        n = avail;
+        scratch.shorts++;
+    }
+    scratch.top = top + n;
+    if (scratch.top > scratch.high) {
+        scratch.high = scratch.top;
+    }
+    if (got != NULL) {
+        *got = n;
+    }
+    return scratch.base + top;
+}
+
+// ============================================================================
+// MicroPython Interface
+// ============================================================================
+
+// scratch(size)
+// Set the size of the scratch arena in bytes, 0 to have none. The kernels
+// that use it fall back to slower paths without it, except capture(),
+// which needs a display row plus 512 bytes.
+static mp_obj_t st7701_scratch(mp_obj_t size_in) {
+    ST7701_TRACE_SCOPE(MP_QSTR_scratch);
+    mp_int_t size = mp_obj_get_int(size_in);
+    if (size < 0 || size > SCRATCH_MAX_SIZE) {
+        mp_raise_ValueError(MP_ERROR_TEXT("size out of range"));
+    }
+    if (scratch.top != 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Scratch arena in use"));
+    }
+
+    heap_caps_free(scratch.base);
+    scratch.base = NULL;
+    scratch.size = 0;
+    if (size > 0) {
+        // Allocate now, so running out of SRAM shows up here
+        scratch.base = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        if (scratch.base == NULL) {
+            mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Scratch arena allocation failed"));
+        }
+        scratch.size = size;
+    }
+    scratch_stats_reset();
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(st7701_scratch_obj, st7701_scratch);
+
+// scratch_stats([reset]) -> (size, high_water, allocs, shorts, fails)
+// high_water is the most of the arena in use at once. shorts counts
+// allocations given less than the kernel asked for, so it worked in
+// smaller tiles, and fails those that got nothing, so it took its slower
+// path. If either is not 0, a bigger arena would help.
+static mp_obj_t st7701_scratch_stats(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_scratch_stats);
+    mp_obj_t tuple[5] = {
+        mp_obj_new_int_from_uint(scratch.size),
+        mp_obj_new_int_from_uint(scratch.high),
+        mp_obj_new_int_from_uint(scratch.allocs),
+        mp_obj_new_int_from_uint(scratch.shorts),
+        mp_obj_new_int_from_uint(scratch.fails),
+    };
+    if (n_args > 0 && mp_obj_is_true(args[0])) {
+        scratch_stats_reset();
+    }
+    return mp_obj_new_tuple(5, tuple);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_scratch_stats_obj, 0, 1, st7701_scratch_stats);
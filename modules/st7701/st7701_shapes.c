@@ -0,0 +1,372 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - anti-aliased shapes
+ *
+ * Circles, rings, arcs, rounded rectangles and thick lines, drawn with
+ * coverage from a signed distance function (SDF): a pixel's alpha is how
+ * far its centre is inside the edge, over a one pixel ramp.
+ *
+ * Every shape is convex, or a convex shape with a convex hole, so each
+ * row splits into a few spans found analytically: an edge ramp, a solid
+ * run, the inner ramp and the hole, mirrored. Only the ramps are shaded
+ * per pixel. Solid runs are plain fills and holes are skipped. An arc is
+ * a ring whose pixels are also faded across its two end edges.
+ *
+ * Coordinates are in surface pixels, and may be fractional. Pixel (x, y)
+ * has its centre at (x, y).
+ */
+
+#include <math.h>
+
+#include "st7701.h"
+
+typedef enum {
+    SHAPE_CIRCLE,
+    SHAPE_ROUND_RECT,
+    SHAPE_CAPSULE,
+} shape_kind_t;
+
+typedef struct _shape_t {
+    shape_kind_t kind;
+    float cx;               // centre (circle, rounded rectangle) or start (capsule)
+    float cy;
+    float r;                // radius, corner radius or half the line width
+    float hw;               // rounded rectangle half width and height
+    float hh;
+    float ux;               // capsule direction, unit length
+    float uy;
+    float len;              // capsule length
+    float width;            // stroke width, 0 if filled
+
+    // Arc: pixels are kept on the inside of both end edges
+    bool sector;
+    bool wide;              // more than 180 degrees - inside either edge
+    float n1x;              // inward normals of the start and end edges
+    float n1y;
+    float n2x;
+    float n2y;
+} shape_t;
+
+// ============================================================================
+// Distance
+// ============================================================================
+
+// Signed distance from (px, py) to the edge of the shape, negative inside
+static float shape_dist(const shape_t *sh, float px, float py) {
+    float dx = px - sh->cx;
+    float dy = py - sh->cy;
+    switch (sh->kind) {
+        case SHAPE_ROUND_RECT: {
+            float qx = fabsf(dx) - (sh->hw - sh->r);
+            float qy = fabsf(dy) - (sh->hh - sh->r);
+            float ox = qx > 0 ? qx : 0;
+            float oy = qy > 0 ? qy : 0;
+            float in = qx > qy ? qx : qy;
+            return sqrtf(ox * ox + oy * oy) + (in < 0 ? in : 0) - sh->r;
+        }
+        case SHAPE_CAPSULE: {
+            float s = dx * sh->ux + dy * sh->uy;
+            s = s < 0 ? 0 : (s > sh->len ? sh->len : s);
+            dx -= s * sh->ux;
+            dy -= s * sh->uy;
+            return sqrtf(dx * dx + dy * dy) - sh->r;
+        }
+        default:
+            return sqrtf(dx * dx + dy * dy) - sh->r;
+    }
+}
+
+// Narrow [*x0, *x1] to the x with lo <= k * x + c <= hi
+static void clamp_linear(float k, float c, float lo, float hi, float *x0, float *x1) {
+    if (fabsf(k) < 1e-6f) {
+        if (c < lo || c > hi) {
+            *x0 = INFINITY;
+            *x1 = -INFINITY;
+        }
+        return;
+    }
+    float a = (lo - c) / k;
+    float b = (hi - c) / k;
+    if (a > b) {
+        float t = a;
+        a = b;
+        b = t;
+    }
+    if (a > *x0) *x0 = a;
+    if (b < *x1) *x1 = b;
+}
+
+// The x on row y where the distance is at most t, as [*x0, *x1]. The shapes
+// are convex, so this is a single interval. Returns false if it is empty.
+static bool shape_span(const shape_t *sh, float y, float t, float *x0, float *x1) {
+    float dy = y - sh->cy;
+    float half;
+    switch (sh->kind) {
+        case SHAPE_ROUND_RECT: {
+            // Offsetting a rounded rectangle by t grows its corners by t,
+            // down to square ones
+            float rr = sh->r + t > 0 ? sh->r + t : 0;
+            float ex = sh->hw + t;
+            float ey = sh->hh + t;
+            dy = fabsf(dy);
+            if (ex <= 0 || dy > ey) {
+                return false;
+            }
+            float qy = dy - (ey - rr);
+            half = qy <= 0 ? ex : ex - rr + sqrtf(rr * rr - qy * qy);
+            break;
+        }
+        case SHAPE_CAPSULE: {
+            // The union of the two end circles and the band between them
+            float r = sh->r + t;
+            if (r <= 0) {
+                return false;
+            }
+            float lo = INFINITY;
+            float hi = -INFINITY;
+            for (int end = 0; end < 2; end++) {
+                float ey = dy - end * sh->len * sh->uy;
+                if (fabsf(ey) <= r) {
+                    float ex = sh->cx + end * sh->len * sh->ux;
+                    float h = sqrtf(r * r - ey * ey);
+                    if (ex - h < lo) lo = ex - h;
+                    if (ex + h > hi) hi = ex + h;
+                }
+            }
+            float bx0 = -INFINITY;
+            float bx1 = INFINITY;
+            clamp_linear(sh->ux, dy * sh->uy - sh->cx * sh->ux, 0, sh->len, &bx0, &bx1);
+            clamp_linear(-sh->uy, dy * sh->ux + sh->cx * sh->uy, -r, r, &bx0, &bx1);
+            if (bx0 <= bx1) {
+                if (bx0 < lo) lo = bx0;
+                if (bx1 > hi) hi = bx1;
+            }
+            if (lo > hi) {
+                return false;
+            }
+            *x0 = lo;
+            *x1 = hi;
+            return true;
+        }
+        default: {
+            float r = sh->r + t;
+            if (r <= 0 || fabsf(dy) > r) {
+                return false;
+            }
+            half = sqrtf(r * r - dy * dy);
+            break;
+        }
+    }
+    *x0 = sh->cx - half;
+    *x1 = sh->cx + half;
+    return true;
+}
+
+// ============================================================================
+// Spans
+// ============================================================================
+
+typedef struct _raster_t {
+    const shape_t *sh;
+    uint16_t *row;
+    float y;
+    uint16_t colour;
+    uint32_t pixels;            // written so far
+} raster_t;
+
+static inline float clamp01(float v) {
+    return v < 0 ? 0 : (v > 1 ? 1 : v);
+}
+
+// Coverage of the arc's sector at a pixel, 0..1
+static inline float sector_coverage(const shape_t *sh, float x, float y) {
+    float dx = x - sh->cx;
+    float dy = y - sh->cy;
+    float d1 = dx * sh->n1x + dy * sh->n1y;
+    float d2 = dx * sh->n2x + dy * sh->n2y;
+    float d = sh->wide ? (d1 > d2 ? d1 : d2) : (d1 < d2 ? d1 : d2);
+    return clamp01(d + 0.5f);
+}
+
+static inline void plot(raster_t *ras, int x, float cover) {
+    uint32_t alpha = (uint32_t)(cover * 32 + 0.5f);
+    if (alpha >= 32) {
+        ras->row[x] = ras->colour;
+    } else if (alpha > 0) {
+        ras->row[x] = blend565(ras->colour, ras->row[x], alpha);
+    } else {
+        return;
+    }
+    ras->pixels++;
+}
+
+// Pixels [x0, x1) on the edge ramps - shaded from the distance
+static void span_edge(raster_t *ras, int x0, int x1) {
+    const shape_t *sh = ras->sh;
+    for (int x = x0; x < x1; x++) {
+        float d = shape_dist(sh, x, ras->y);
+        float cover = clamp01(0.5f - d);
+        if (sh->width > 0) {
+            cover -= clamp01(0.5f - d - sh->width);
+        }
+        if (sh->sector) {
+            cover *= sector_coverage(sh, x, ras->y);
+        }
+        plot(ras, x, cover);
+    }
+}
+
+// Pixels [x0, x1) fully inside the shape
+static void span_solid(raster_t *ras, int x0, int x1) {
+    if (x0 >= x1) {
+        return;
+    }
+    if (!ras->sh->sector) {
+        st7701_fill_span(ras->row + x0, x1 - x0, ras->colour);
+        ras->pixels += x1 - x0;
+        return;
+    }
+    for (int x = x0; x < x1; x++) {
+        plot(ras, x, sector_coverage(ras->sh, x, ras->y));
+    }
+}
+
+// First and one past the last pixel centre in [x0, x1], clipped
+static void pixel_range(float x0, float x1, const st7701_rect_t *clip, int *p0, int *p1) {
+    int a = (int)ceilf(x0);
+    int b = (int)floorf(x1) + 1;
+    *p0 = a < clip->x0 ? clip->x0 : (a > clip->x1 ? clip->x1 : a);
+    *p1 = b > clip->x1 ? clip->x1 : (b < *p0 ? *p0 : b);
+}
+
+// Draw a shape covering rows [y0, y1] (before clipping). Returns the
+// number of pixels written.
+static uint32_t shape_draw(const st7701_surface_t *s, const st7701_rect_t *clip, const shape_t *sh,
+                           float y0, float y1, uint16_t colour) {
+    st7701_rect_t c = *clip;
+    st7701_clip_to_surface(&c, s);
+    int row0 = (int)ceilf(y0);
+    int row1 = (int)floorf(y1) + 1;
+    if (row0 < c.y0) row0 = c.y0;
+    if (row1 > c.y1) row1 = c.y1;
+
+    raster_t ras = { .sh = sh, .colour = colour, .pixels = 0 };
+    float w = sh->width;
+    for (int y = row0; y < row1; y++) {
+        ras.row = s->pixels + y * s->stride;
+        ras.y = y;
+
+        // Nested spans, outermost first: anything (a), solid (b), inner
+        // ramp (d) and hole (h). b, d and h may be empty.
+        float fa0, fa1, fb0, fb1, fd0, fd1, fh0, fh1;
+        if (!shape_span(sh, y, 0.5f, &fa0, &fa1)) {
+            continue;
+        }
+        int a0, a1, b0, b1, d0, d1, h0, h1;
+        pixel_range(fa0, fa1, &c, &a0, &a1);
+        if (shape_span(sh, y, -0.5f, &fb0, &fb1)) {
+            pixel_range(fb0, fb1, &c, &b0, &b1);
+        } else {
+            b0 = b1 = a1;
+        }
+        if (w > 0 && b0 < b1 && shape_span(sh, y, 0.5f - w, &fd0, &fd1)) {
+            pixel_range(fd0, fd1, &c, &d0, &d1);
+        } else {
+            d0 = d1 = b1;
+        }
+        if (w > 0 && d0 < d1 && shape_span(sh, y, -0.5f - w, &fh0, &fh1)) {
+            pixel_range(fh0, fh1, &c, &h0, &h1);
+        } else {
+            h0 = h1 = d1;
+        }
+        // Keep them nested whatever rounding did
+        b0 = b0 < a0 ? a0 : b0;
+        b1 = b1 > a1 ? a1 : (b1 < b0 ? b0 : b1);
+        d0 = d0 < b0 ? b0 : d0;
+        d1 = d1 > b1 ? b1 : (d1 < d0 ? d0 : d1);
+        h0 = h0 < d0 ? d0 : h0;
+        h1 = h1 > d1 ? d1 : (h1 < h0 ? h0 : h1);
+
+        span_edge(&ras, a0, b0);
+        span_solid(&ras, b0, d0);
+        span_edge(&ras, d0, h0);
+        span_edge(&ras, h1, d1);
+        span_solid(&ras, d1, b1);
+        span_edge(&ras, b1, a1);
+    }
+    return ras.pixels;
+}
+
+// ============================================================================
+// Shapes
+// ============================================================================
+
+// Strokes under a pixel wide would overlap their own ramps
+static float stroke_width(float width) {
+    return width <= 0 ? 0 : (width < 1 ? 1 : width);
+}
+
+uint32_t st7701_shape_circle(const st7701_surface_t *s, const st7701_rect_t *clip,
+                             float cx, float cy, float r, float width, uint16_t colour) {
+    shape_t sh = { .kind = SHAPE_CIRCLE, .cx = cx, .cy = cy, .r = r, .width = stroke_width(width) };
+    return shape_draw(s, clip, &sh, cy - r - 0.5f, cy + r + 0.5f, colour);
+}
+
+uint32_t st7701_shape_arc(const st7701_surface_t *s, const st7701_rect_t *clip,
+                          float cx, float cy, float r, float width, float start, float end, uint16_t colour) {
+    shape_t sh = { .kind = SHAPE_CIRCLE, .cx = cx, .cy = cy, .r = r, .width = stroke_width(width) };
+
+    float sweep = end - start;
+    if (sweep <= 0) {
+        sweep += 360 * ceilf(-sweep / 360 + 1e-6f);
+    }
+    if (sweep < 360) {
+        // Degrees clockwise from 12 o'clock, y down: direction (sin, -cos).
+        // Inside is clockwise of the start edge and anticlockwise of the end.
+        float a1 = start * (float)M_PI / 180;
+        float a2 = (start + sweep) * (float)M_PI / 180;
+        sh.sector = true;
+        sh.wide = sweep > 180;
+        sh.n1x = cosf(a1);
+        sh.n1y = sinf(a1);
+        sh.n2x = -cosf(a2);
+        sh.n2y = -sinf(a2);
+    }
+    return shape_draw(s, clip, &sh, cy - r - 0.5f, cy + r + 0.5f, colour);
+}
+
+uint32_t st7701_shape_round_rect(const st7701_surface_t *s, const st7701_rect_t *clip,
+                                 float x, float y, float w, float h, float r, float width, uint16_t colour) {
+    // Covers the pixels x .. x + w - 1, like fill_rect()
+    float hw = w / 2;
+    float hh = h / 2;
+    float max_r = hw < hh ? hw : hh;
+    shape_t sh = {
+        .kind = SHAPE_ROUND_RECT,
+        .cx = x - 0.5f + hw,
+        .cy = y - 0.5f + hh,
+        .r = r < 0 ? 0 : (r > max_r ? max_r : r),
+        .hw = hw,
+        .hh = hh,
+        .width = stroke_width(width),
+    };
+    return shape_draw(s, clip, &sh, y - 1, y + h, colour);
+}
+
+uint32_t st7701_shape_line(const st7701_surface_t *s, const st7701_rect_t *clip,
+                           float x0, float y0, float x1, float y1, float width, uint16_t colour) {
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    float len = sqrtf(dx * dx + dy * dy);
+    shape_t sh = {
+        .kind = SHAPE_CAPSULE,
+        .cx = x0,
+        .cy = y0,
+        .r = (width < 1 ? 1 : width) / 2,
+        .ux = len > 0 ? dx / len : 1,
+        .uy = len > 0 ? dy / len : 0,
+        .len = len,
+    };
+    float top = y0 < y1 ? y0 : y1;
+    float bottom = y0 < y1 ? y1 : y0;
+    return shape_draw(s, clip, &sh, top - sh.r - 0.5f, bottom + sh.r + 0.5f, colour);
+}
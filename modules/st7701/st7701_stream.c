@@ -0,0 +1,371 @@
+/*
+ * ST7701 frame stream decoder - see st7701_stream.h for the protocol
+ */
+
+#include <string.h>
+
+#include "st7701_stream.h"
+
+enum {
+    ST_SYNC,
+    ST_HEADER,          // type + length
+    ST_FIXED,           // fixed-size payload fields into hdr[]
+    ST_RAW,
+    ST_RLE_CTRL,
+    ST_RLE_RUN,         // value of a run
+    ST_RLE_LITERAL,     // literal values
+    ST_SKIP,            // rest of a bad or unknown packet
+};
+
+void st7701_stream_init(st7701_stream_t *s, const st7701_stream_target_t *target) {
+    memset(s, 0, sizeof(*s));
+    s->target = *target;
+    s->state = ST_SYNC;
+}
+
+// ============================================================================
+// Frames
+// ============================================================================
+
+static void copy_rect(uint16_t *dst, const uint16_t *src, int width, const st7701_stream_rect_t *r) {
+    for (int y = r->y; y < r->y + r->h; y++) {
+        memcpy(dst + y * width + r->x, src + y * width + r->x, r->w * 2);
+    }
+}
+
+// Bring the back buffer up to date with the frame on screen, by copying
+// the rectangles the last frame changed
+static void catch_up(st7701_stream_t *s) {
+    uint16_t *back = s->target.back_buffer(s->target.ctx);
+    const uint16_t *front = s->target.front_buffer(s->target.ctx);
+    if (back == front || s->prev_count == 0) {
+        s->prev_count = 0;
+        return;
+    }
+
+    if (s->prev_count > STREAM_MAX_RECTS) {
+        memcpy(back, front, s->target.width * s->target.height * 2);
+    } else {
+        for (int i = 0; i < s->prev_count; i++) {
+            copy_rect(back, front, s->target.width, &s->prev_rects[i]);
+        }
+    }
+    s->prev_count = 0;
+}
+
+static void frame_end(st7701_stream_t *s) {
+    // A frame with no FRAME_BEGIN and no rectangles hasn't caught up yet,
+    // and flipping now would show the back buffer a frame behind
+    if (s->prev_count) {
+        catch_up(s);
+    }
+    s->target.flip(s->target.ctx);
+    memcpy(s->prev_rects, s->cur_rects, sizeof(s->prev_rects));
+    s->prev_count = s->cur_count;
+    s->cur_count = 0;
+    s->stats.frames++;
+}
+
+static void remember_rect(st7701_stream_t *s, int x0, int y0, int x1, int y1) {
+    if (s->cur_count < STREAM_MAX_RECTS) {
+        st7701_stream_rect_t *r = &s->cur_rects[s->cur_count];
+        r->x = x0;
+        r->y = y0;
+        r->w = x1 - x0;
+        r->h = y1 - y0;
+    }
+    if (s->cur_count <= STREAM_MAX_RECTS) {
+        s->cur_count++;     // STREAM_MAX_RECTS + 1 means overflowed
+    }
+}
+
+// Start a rectangle from the x, y, w, h in hdr[]. Returns false if invalid.
+static bool rect_begin(st7701_stream_t *s) {
+    int x = s->hdr[0] | (s->hdr[1] << 8);
+    int y = s->hdr[2] | (s->hdr[3] << 8);
+    int w = s->hdr[4] | (s->hdr[5] << 8);
+    int h = s->hdr[6] | (s->hdr[7] << 8);
+
+    int W = s->target.width;
+    int H = s->target.height;
+    bool swapped = s->rotation & 1;
+    int lw = swapped ? H : W;
+    int lh = swapped ? W : H;
+    if (w <= 0 || h <= 0 || x + w > lw || y + h > lh) {
+        return false;
+    }
+
+    if (s->prev_count) {
+        catch_up(s);
+    }
+
+    // Physical address of logical (x, y), and pointer steps for +x and +y
+    int base;
+    switch (s->rotation) {
+        case 0:
+            base = y * W + x;
+            s->step_x = 1;
+            s->step_y = W;
+            remember_rect(s, x, y, x + w, y + h);
+            break;
+        case 1:     // 90: physical (W - 1 - ly, lx)
+            base = x * W + (W - 1 - y);
+            s->step_x = W;
+            s->step_y = -1;
+            remember_rect(s, W - y - h, x, W - y, x + w);
+            break;
+        case 2:     // 180: physical (W - 1 - lx, H - 1 - ly)
+            base = (H - 1 - y) * W + (W - 1 - x);
+            s->step_x = -1;
+            s->step_y = -W;
+            remember_rect(s, W - x - w, H - y - h, W - x, H - y);
+            break;
+        default:    // 270: physical (ly, H - 1 - lx)
+            base = (H - 1 - x) * W + y;
+            s->step_x = -W;
+            s->step_y = 1;
+            remember_rect(s, y, H - x - w, y + h, H - x);
+            break;
+    }
+
+    s->row_ptr = s->target.back_buffer(s->target.ctx) + base;
+    s->rect_w = w;
+    s->rect_h = h;
+    s->col = 0;
+    s->row = 0;
+    s->have_lo = false;
+    s->stats.rects++;
+    return true;
+}
+
+static inline bool rect_done(const st7701_stream_t *s) {
+    return s->row >= s->rect_h;
+}
+
+// Write (or XOR) n copies of a value at the rectangle cursor
+static void emit(st7701_stream_t *s, uint16_t value, int n, bool xor) {
+    while (n > 0 && !rect_done(s)) {
+        int span = s->rect_w - s->col;
+        if (span > n) {
+            span = n;
+        }
+        uint16_t *p = s->row_ptr + s->col * s->step_x;
+        if (xor) {
+            if (value != 0) {
+                for (int i = 0; i < span; i++, p += s->step_x) {
+                    *p ^= value;
+                }
+            }
+        } else {
+            for (int i = 0; i < span; i++, p += s->step_x) {
+                *p = value;
+            }
+        }
+        s->col += span;
+        n -= span;
+        if (s->col == s->rect_w) {
+            s->col = 0;
+            s->row++;
+            s->row_ptr += s->step_y;
+        }
+    }
+}
+
+// ============================================================================
+// Packets
+// ============================================================================
+
+// Called once the header of a packet is complete
+static void packet_begin(st7701_stream_t *s) {
+    s->type = s->hdr[0];
+    s->remaining = s->hdr[1] | (s->hdr[2] << 8) | (s->hdr[3] << 16) | ((uint32_t)s->hdr[4] << 24);
+    s->hdr_len = 0;
+
+    switch (s->type) {
+        case STREAM_FRAME_END:
+            frame_end(s);
+            s->state = s->remaining ? ST_SKIP : ST_SYNC;
+            return;
+        case STREAM_FRAME_BEGIN:
+        case STREAM_RECT_RAW:
+        case STREAM_RECT_RLE:
+        case STREAM_RECT_XOR:
+        case STREAM_FILL:
+            s->state = ST_FIXED;
+            return;
+        default:
+            s->stats.errors++;
+            s->state = s->remaining ? ST_SKIP : ST_SYNC;
+            return;
+    }
+}
+
+static int fixed_size(uint8_t type) {
+    switch (type) {
+        case STREAM_FRAME_BEGIN: return 1;
+        case STREAM_FILL:        return 10;
+        default:                 return 8;
+    }
+}
+
+// Called once the fixed fields of a packet are in hdr[]
+static void fields_done(st7701_stream_t *s) {
+    if (s->type == STREAM_FRAME_BEGIN) {
+        s->rotation = s->hdr[0] & 3;
+        if (s->prev_count) {
+            catch_up(s);
+        }
+        s->state = s->remaining ? ST_SKIP : ST_SYNC;
+        return;
+    }
+
+    if (!rect_begin(s)) {
+        s->stats.errors++;
+        s->state = s->remaining ? ST_SKIP : ST_SYNC;
+        return;
+    }
+
+    switch (s->type) {
+        case STREAM_FILL:
+            emit(s, s->hdr[8] | (s->hdr[9] << 8), s->rect_w * s->rect_h, false);
+            s->state = s->remaining ? ST_SKIP : ST_SYNC;
+            break;
+        case STREAM_RECT_RAW:
+            s->state = ST_RAW;
+            break;
+        default:
+            s->state = ST_RLE_CTRL;
+            break;
+    }
+}
+
+// Once a packet's payload is used up, go back to looking for the next one.
+// Pixels still expected at that point mean a malformed packet.
+static void packet_check_end(st7701_stream_t *s) {
+    if (s->state <= ST_HEADER || s->remaining != 0) {
+        return;
+    }
+    if (s->state != ST_SKIP && !((s->state == ST_RLE_CTRL || s->state == ST_RAW) && rect_done(s))) {
+        s->stats.errors++;
+    }
+    s->state = ST_SYNC;
+}
+
+void st7701_stream_feed(st7701_stream_t *s, const uint8_t *data, size_t len) {
+    const uint8_t *end = data + len;
+    s->stats.bytes += len;
+
+    while (data < end) {
+        packet_check_end(s);
+
+        switch (s->state) {
+            case ST_SYNC:
+                if (*data++ == STREAM_SYNC) {
+                    s->state = ST_HEADER;
+                    s->hdr_len = 0;
+                } else {
+                    s->stats.errors++;
+                }
+                break;
+
+            case ST_HEADER:
+                s->hdr[s->hdr_len++] = *data++;
+                if (s->hdr_len == 5) {
+                    packet_begin(s);
+                }
+                break;
+
+            case ST_FIXED:
+                s->hdr[s->hdr_len++] = *data++;
+                s->remaining--;
+                if (s->hdr_len == fixed_size(s->type)) {
+                    fields_done(s);
+                }
+                break;
+
+            case ST_RAW:
+                if (rect_done(s)) {
+                    s->state = ST_SKIP;
+                    s->stats.errors++;
+                    break;
+                }
+                // Fast path: whole pixels straight into an unrotated row
+                if (!s->have_lo && s->step_x == 1) {
+                    size_t avail = end - data;
+                    if (avail > s->remaining) {
+                        avail = s->remaining;
+                    }
+                    size_t n = (s->rect_w - s->col) * 2;
+                    if (n > (avail & ~1u)) {
+                        n = avail & ~1u;
+                    }
+                    if (n > 0) {
+                        memcpy(s->row_ptr + s->col, data, n);
+                        data += n;
+                        s->remaining -= n;
+                        s->col += n / 2;
+                        if (s->col == s->rect_w) {
+                            s->col = 0;
+                            s->row++;
+                            s->row_ptr += s->step_y;
+                        }
+                        break;
+                    }
+                }
+                s->remaining--;
+                if (!s->have_lo) {
+                    s->lo = *data++;
+                    s->have_lo = true;
+                } else {
+                    emit(s, s->lo | (*data++ << 8), 1, false);
+                    s->have_lo = false;
+                }
+                break;
+
+            case ST_RLE_CTRL:
+                s->ctrl = *data++;
+                s->remaining--;
+                s->count = (s->ctrl & 0x7F) + 1;
+                s->have_lo = false;
+                s->state = (s->ctrl & 0x80) ? ST_RLE_RUN : ST_RLE_LITERAL;
+                break;
+
+            case ST_RLE_RUN:
+            case ST_RLE_LITERAL: {
+                s->remaining--;
+                if (!s->have_lo) {
+                    s->lo = *data++;
+                    s->have_lo = true;
+                    break;
+                }
+                s->have_lo = false;
+                uint16_t value = s->lo | (*data++ << 8);
+                bool xor = s->type == STREAM_RECT_XOR;
+                if (s->state == ST_RLE_RUN) {
+                    emit(s, value, s->count, xor);
+                    s->count = 0;
+                } else {
+                    emit(s, value, 1, xor);
+                    s->count--;
+                }
+                if (s->count == 0) {
+                    s->state = ST_RLE_CTRL;
+                }
+                break;
+            }
+
+            default: {  // ST_SKIP
+                size_t n = end - data;
+                if (n > s->remaining) {
+                    n = s->remaining;
+                }
+                data += n;
+                s->remaining -= n;
+                break;
+            }
+        }
+    }
+
+    // A packet that ends exactly at the end of this chunk
+    packet_check_end(s);
+}
@@ -0,0 +1,110 @@
+/*
+ * ST7701 frame stream decoder
+ *
+ * Plain C with no MicroPython or ESP-IDF dependencies, so the same decoder
+ * runs on the device and on a PC (see utils/stream_host.c).
+ *
+ * Protocol, little-endian. Every packet is:
+ *   u8  sync (0xA5)
+ *   u8  type
+ *   u32 payload length
+ *   payload
+ *
+ * Packet types:
+ *   FRAME_BEGIN  u8 rotation (0-3 = 0, 90, 180, 270 degrees clockwise)
+ *   FRAME_END    no payload - flip buffers
+ *   RECT_RAW     u16 x, y, w, h, then w*h RGB565 pixels
+ *   RECT_RLE     u16 x, y, w, h, then RLE pixels
+ *   RECT_XOR     u16 x, y, w, h, then RLE values XORed into the current frame
+ *   FILL         u16 x, y, w, h, colour
+ *
+ * RLE: a control byte c. If c & 0x80, (c & 0x7F) + 1 copies of the next u16
+ * follow, otherwise c + 1 literal u16 values follow. In RECT_XOR a run of
+ * zeros leaves the pixels untouched.
+ *
+ * Rectangles are in the rotated (logical) coordinate space of the frame.
+ */
+
+#ifndef ST7701_STREAM_H
+#define ST7701_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define STREAM_SYNC             0xA5
+
+#define STREAM_FRAME_BEGIN      0x01
+#define STREAM_FRAME_END        0x02
+#define STREAM_RECT_RAW         0x10
+#define STREAM_RECT_RLE         0x11
+#define STREAM_RECT_XOR         0x12
+#define STREAM_FILL             0x13
+
+// Rectangles remembered per frame for catching up the back buffer
+#define STREAM_MAX_RECTS        32
+
+// Where decoded pixels go. front may equal back for a single buffer.
+typedef struct _st7701_stream_target_t {
+    uint16_t *(*back_buffer)(void *ctx);
+    const uint16_t *(*front_buffer)(void *ctx);
+    void (*flip)(void *ctx);
+    void *ctx;
+    int width;
+    int height;
+} st7701_stream_target_t;
+
+typedef struct _st7701_stream_rect_t {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+} st7701_stream_rect_t;
+
+typedef struct _st7701_stream_stats_t {
+    uint32_t frames;
+    uint32_t rects;
+    uint32_t bytes;
+    uint32_t errors;        // bad sync bytes or malformed packets
+} st7701_stream_stats_t;
+
+typedef struct _st7701_stream_t {
+    st7701_stream_target_t target;
+    st7701_stream_stats_t stats;
+
+    // Packet parsing
+    uint8_t state;
+    uint8_t type;
+    uint8_t hdr[10];
+    uint8_t hdr_len;
+    uint32_t remaining;     // payload bytes left in the current packet
+
+    // Current rectangle, walked in logical raster order
+    uint8_t rotation;
+    int16_t rect_w;
+    int16_t rect_h;
+    int16_t col;
+    int16_t row;
+    uint16_t *row_ptr;      // physical address of (0, row) in the rectangle
+    int step_x;             // pointer step for +1 logical x
+    int step_y;             // pointer step for +1 logical y
+
+    // RLE state
+    uint8_t ctrl;
+    uint16_t count;
+    uint8_t lo;             // low byte of a pixel split across feeds
+    bool have_lo;
+
+    // Physical rectangles written in the previous and current frame
+    st7701_stream_rect_t prev_rects[STREAM_MAX_RECTS];
+    st7701_stream_rect_t cur_rects[STREAM_MAX_RECTS];
+    uint8_t prev_count;     // STREAM_MAX_RECTS + 1 = overflowed, copy everything
+    uint8_t cur_count;
+} st7701_stream_t;
+
+void st7701_stream_init(st7701_stream_t *s, const st7701_stream_target_t *target);
+
+// Decode a chunk of the stream. Packets may be split anywhere.
+void st7701_stream_feed(st7701_stream_t *s, const uint8_t *data, size_t len);
+
+#endif // ST7701_STREAM_H
@@ -0,0 +1,518 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - text rendering
+ *
+ * Fonts are converted on a PC by utils/font2bin.py into anti-aliased A4 or
+ * A8 glyph bitmaps plus metrics and kerning pairs. Glyphs are expanded to A8
+ * into a small cache in internal SRAM and blended straight into RGB565.
+ */
+
+#include "py/runtime.h"
+#include "py/obj.h"
+
+#include "esp_heap_caps.h"
+
+#include "st7701.h"
+
+// Font file layout (little-endian):
+//   header    20 bytes
+//   glyphs    glyph_count * 16 bytes, sorted by codepoint
+//   kerning   kern_count * 8 bytes, sorted by (left, right)
+//   bitmaps   A4 rows are padded to a whole byte, high nibble first
+#define FONT_MAGIC          "S7FT"
+#define FONT_VERSION        1
+#define FONT_NO_GLYPH       0xFFFF
+
+typedef struct __attribute__((packed)) _font_header_t {
+    char magic[4];
+    uint8_t version;
+    uint8_t bpp;            // 4 or 8
+    uint16_t glyph_count;
+    uint16_t kern_count;
+    uint16_t line_height;
+    int16_t ascent;         // pixels above the baseline
+    int16_t descent;        // pixels below the baseline
+    uint16_t fallback;      // glyph drawn for missing characters, or FONT_NO_GLYPH
+    uint16_t reserved;
+} font_header_t;
+
+typedef struct __attribute__((packed)) _font_glyph_t {
+    uint32_t codepoint;
+    uint32_t offset;        // from the start of the bitmaps
+    uint8_t w;
+    uint8_t h;
+    int8_t x_off;           // bitmap left edge relative to the pen
+    int8_t y_off;           // bitmap top edge relative to the baseline
+    uint8_t advance;
+    uint8_t pad[3];
+} font_glyph_t;
+
+typedef struct __attribute__((packed)) _font_kern_t {
+    uint16_t left;          // glyph indices
+    uint16_t right;
+    int16_t adjust;
+    uint16_t pad;
+} font_kern_t;
+
+typedef struct _st7701_font_obj_t {
+    mp_obj_base_t base;
+    mp_obj_t data_obj;              // keeps the font data alive
+    const font_header_t *header;
+    const font_glyph_t *glyphs;
+    const font_kern_t *kerns;
+    const uint8_t *bitmaps;
+    uint32_t id;                    // identifies this font in the glyph cache
+    uint16_t ascii[95];             // glyph index for ' '..'~'
+} st7701_font_obj_t;
+
+// ============================================================================
+// Glyph Cache
+// ============================================================================
+
+// Expanded A8 glyphs in internal SRAM, looked up through a direct-mapped
+// table. When the pool fills up the whole cache is flushed - glyph sets are
+// small, so it refills within a frame.
+#define GLYPH_CACHE_BYTES   (16 * 1024)
+#define GLYPH_CACHE_SLOTS   256
+
+typedef struct _glyph_slot_t {
+    uint32_t font_id;
+    uint16_t glyph;
+    uint8_t *alpha;
+} glyph_slot_t;
+
+static glyph_slot_t glyph_slots[GLYPH_CACHE_SLOTS];
+static uint8_t *glyph_pool;
+static size_t glyph_pool_used;
+static uint32_t next_font_id = 1;
+
+static void glyph_cache_flush(void) {
+    memset(glyph_slots, 0, sizeof(glyph_slots));
+    glyph_pool_used = 0;
+}
+
+// Returns A8 alpha for a glyph (stride = w), or NULL if it can't be cached
+static const uint8_t *glyph_cache_get(const st7701_font_obj_t *font, uint16_t index) {
+    const font_glyph_t *g = &font->glyphs[index];
+    size_t size = g->w * g->h;
+
+    if (glyph_pool == NULL) {
+        glyph_pool = heap_caps_malloc(GLYPH_CACHE_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (glyph_pool == NULL) {
+            return NULL;
+        }
+        glyph_cache_flush();
+    }
+    if (size > GLYPH_CACHE_BYTES / 4) {
+        return NULL;
+    }
+
+    glyph_slot_t *slot = &glyph_slots[(font->id * 37 + index) & (GLYPH_CACHE_SLOTS - 1)];
+    if (slot->font_id == font->id && slot->glyph == index) {
+        return slot->alpha;
+    }
+
+    if (glyph_pool_used + size > GLYPH_CACHE_BYTES) {
+        glyph_cache_flush();
+    }
+    uint8_t *alpha = glyph_pool + glyph_pool_used;
+    glyph_pool_used += size;
+
+    const uint8_t *src = font->bitmaps + g->offset;
+    if (font->header->bpp == 8) {
+        memcpy(alpha, src, size);
+    } else {
+        int stride = (g->w + 1) / 2;
+        for (int y = 0; y < g->h; y++) {
+            for (int x = 0; x < g->w; x++) {
+                uint8_t v = src[y * stride + x / 2];
+                v = (x & 1) ? (v & 0x0F) : (v >> 4);
+                alpha[y * g->w + x] = v * 17;
+            }
+        }
+    }
+
+    slot->font_id = font->id;
+    slot->glyph = index;
+    slot->alpha = alpha;
+    return alpha;
+}
+
+// ============================================================================
+// Layout
+// ============================================================================
+
+// Decode one UTF-8 character, advancing *p. Invalid bytes decode as themselves.
+static uint32_t utf8_next(const char **p, const char *end) {
+    const uint8_t *s = (const uint8_t *)*p;
+    uint32_t c = *s++;
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    if (extra) {
+        c &= 0x3F >> extra;
+        while (extra-- && s < (const uint8_t *)end && (*s & 0xC0) == 0x80) {
+            c = (c << 6) | (*s++ & 0x3F);
+        }
+    }
+    *p = (const char *)s;
+    return c;
+}
+
+static uint16_t font_find_glyph(const st7701_font_obj_t *font, uint32_t cp) {
+    if (cp >= 0x20 && cp < 0x7F) {
+        uint16_t index = font->ascii[cp - 0x20];
+        return index != FONT_NO_GLYPH ? index : font->header->fallback;
+    }
+
+    int lo = 0;
+    int hi = font->header->glyph_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        uint32_t mid_cp = font->glyphs[mid].codepoint;
+        if (mid_cp == cp) {
+            return mid;
+        } else if (mid_cp < cp) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return font->header->fallback;
+}
+
+static int font_kerning(const st7701_font_obj_t *font, uint16_t left, uint16_t right) {
+    uint32_t key = ((uint32_t)left << 16) | right;
+    int lo = 0;
+    int hi = font->header->kern_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const font_kern_t *k = &font->kerns[mid];
+        uint32_t mid_key = ((uint32_t)k->left << 16) | k->right;
+        if (mid_key == key) {
+            return k->adjust;
+        } else if (mid_key < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return 0;
+}
+
+// Width of one line of text, stopping at '\n' or end. *p is left after the line.
+static int font_line_width(const st7701_font_obj_t *font, const char **p, const char *end) {
+    int width = 0;
+    uint16_t prev = FONT_NO_GLYPH;
+    while (*p < end) {
+        uint32_t cp = utf8_next(p, end);
+        if (cp == '\n') {
+            break;
+        }
+        uint16_t index = font_find_glyph(font, cp);
+        if (index == FONT_NO_GLYPH) {
+            continue;
+        }
+        if (prev != FONT_NO_GLYPH && font->header->kern_count) {
+            width += font_kerning(font, prev, index);
+        }
+        width += font->glyphs[index].advance;
+        prev = index;
+    }
+    return width;
+}
+
+// ============================================================================
+// Rendering
+// ============================================================================
+
+static void fill_span_rect(const st7701_surface_t *s, int x0, int y0, int x1, int y1, uint16_t colour) {
+    for (int y = y0; y < y1; y++) {
+        uint16_t *row = s->pixels + y * s->stride;
+        for (int x = x0; x < x1; x++) {
+            row[x] = colour;
+        }
+    }
+}
+
+// Blend one glyph with its bitmap top-left at (gx, gy). ramp, if given, holds
+// the 33 pre-blended colours over an opaque background.
+static void draw_glyph(const st7701_surface_t *s, const st7701_rect_t *clip,
+                       const st7701_font_obj_t *font, uint16_t index, int gx, int gy,
+                       uint16_t colour, const uint16_t *ramp) {
+    const font_glyph_t *g = &font->glyphs[index];
+
+    int x0 = gx > clip->x0 ? gx : clip->x0;
+    int y0 = gy > clip->y0 ? gy : clip->y0;
+    int x1 = gx + g->w < clip->x1 ? gx + g->w : clip->x1;
+    int y1 = gy + g->h < clip->y1 ? gy + g->h : clip->y1;
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    const uint8_t *alpha = glyph_cache_get(font, index);
+    const uint8_t *src4 = font->bitmaps + g->offset;
+    int stride4 = (g->w + 1) / 2;
+
+    for (int y = y0; y < y1; y++) {
+        uint16_t *out = s->pixels + y * s->stride;
+        const uint8_t *a_row = alpha ? alpha + (y - gy) * g->w - gx : NULL;
+
+        for (int x = x0; x < x1; x++) {
+            uint32_t a;
+            if (a_row) {
+                a = a_row[x];
+            } else if (font->header->bpp == 8) {
+                a = src4[(y - gy) * g->w + (x - gx)];
+            } else {
+                int sx = x - gx;
+                uint8_t v = src4[(y - gy) * stride4 + sx / 2];
+                a = ((sx & 1) ? (v & 0x0F) : (v >> 4)) * 17;
+            }
+
+            if (a == 0) {
+                continue;
+            }
+            a = (a + 4) >> 3;
+            if (ramp) {
+                out[x] = ramp[a];
+            } else if (a >= 32) {
+                out[x] = colour;
+            } else {
+                out[x] = blend565(colour, out[x], a);
+            }
+        }
+    }
+}
+
+int st7701_text_draw(const st7701_surface_t *surface, const st7701_rect_t *clip_in, mp_obj_t font_in,
+                     const char *str, size_t len, int x, int y, uint16_t colour, int32_t bg) {
+    if (mp_obj_is_type(font_in, &st7701_asset_type)) {
+        font_in = st7701_asset_font(font_in);
+    }
+    if (!mp_obj_is_type(font_in, &st7701_font_type)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("expected a Font"));
+    }
+    const st7701_font_obj_t *font = MP_OBJ_TO_PTR(font_in);
+    const font_header_t *hdr = font->header;
+
+    st7701_rect_t clip = *clip_in;
+    st7701_clip_to_surface(&clip, surface);
+
+    // With an opaque background every alpha level maps to a fixed colour, so
+    // glyphs never read back from the (PSRAM) framebuffer
+    uint16_t ramp[33];
+    if (bg >= 0) {
+        for (int a = 0; a <= 32; a++) {
+            ramp[a] = blend565(colour, bg, a);
+        }
+    }
+
+    const char *p = str;
+    const char *end = str + len;
+    int pen_x = x;
+
+    while (p < end && clip.x0 < clip.x1 && clip.y0 < clip.y1) {
+        // Fill the line box first so overhanging glyphs aren't cut by their
+        // neighbour's background
+        if (bg >= 0) {
+            const char *q = p;
+            int w = font_line_width(font, &q, end);
+            int fx0 = x > clip.x0 ? x : clip.x0;
+            int fy0 = y > clip.y0 ? y : clip.y0;
+            int fx1 = x + w < clip.x1 ? x + w : clip.x1;
+            int fy1 = y + hdr->line_height < clip.y1 ? y + hdr->line_height : clip.y1;
+            if (fx0 < fx1 && fy0 < fy1) {
+                fill_span_rect(surface, fx0, fy0, fx1, fy1, bg);
+            }
+        }
+
+        int baseline = y + hdr->ascent;
+        uint16_t prev = FONT_NO_GLYPH;
+        pen_x = x;
+
+        while (p < end) {
+            uint32_t cp = utf8_next(&p, end);
+            if (cp == '\n') {
+                break;
+            }
+            uint16_t index = font_find_glyph(font, cp);
+            if (index == FONT_NO_GLYPH) {
+                continue;
+            }
+            if (prev != FONT_NO_GLYPH && hdr->kern_count) {
+                pen_x += font_kerning(font, prev, index);
+            }
+
+            const font_glyph_t *g = &font->glyphs[index];
+            if (g->w && g->h) {
+                draw_glyph(surface, &clip, font, index, pen_x + g->x_off, baseline + g->y_off,
+                           colour, bg >= 0 ? ramp : NULL);
+            }
+            pen_x += g->advance;
+            prev = index;
+        }
+
+        y += hdr->line_height;
+    }
+
+    return pen_x;
+}
+
+// ============================================================================
+// MicroPython Interface
+// ============================================================================
+
+// Font(data) or Font(path) - data is the contents of a file from font2bin.py
+static mp_obj_t st7701_font_make_new(const mp_obj_type_t *type, size_t n_args,
+                                     size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+
+    mp_obj_t data_obj = args[0];
+    if (mp_obj_is_str(data_obj)) {
+        mp_obj_t open_args[2] = { data_obj, MP_OBJ_NEW_QSTR(MP_QSTR_rb) };
+        mp_obj_t file = mp_call_function_n_kw(MP_OBJ_FROM_PTR(&mp_builtin_open_obj), 2, 0, open_args);
+        mp_obj_t dest[2];
+        mp_load_method(file, MP_QSTR_read, dest);
+        data_obj = mp_call_method_n_kw(0, 0, dest);
+        mp_load_method(file, MP_QSTR_close, dest);
+        mp_call_method_n_kw(0, 0, dest);
+    }
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(data_obj, &bufinfo, MP_BUFFER_READ);
+
+    const font_header_t *hdr = bufinfo.buf;
+    if (bufinfo.len < sizeof(font_header_t) || memcmp(hdr->magic, FONT_MAGIC, 4) != 0 ||
+        hdr->version != FONT_VERSION || (hdr->bpp != 4 && hdr->bpp != 8)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("not a font2bin font"));
+    }
+
+    size_t tables = sizeof(font_header_t) + hdr->glyph_count * sizeof(font_glyph_t) +
+                    hdr->kern_count * sizeof(font_kern_t);
+    if (bufinfo.len < tables) {
+        mp_raise_ValueError(MP_ERROR_TEXT("font data truncated"));
+    }
+
+    st7701_font_obj_t *self = mp_obj_malloc(st7701_font_obj_t, type);
+    self->data_obj = data_obj;
+    self->header = hdr;
+    self->glyphs = (const font_glyph_t *)((const uint8_t *)bufinfo.buf + sizeof(font_header_t));
+    self->kerns = (const font_kern_t *)(self->glyphs + hdr->glyph_count);
+    self->bitmaps = (const uint8_t *)bufinfo.buf + tables;
+    self->id = next_font_id++;
+
+    // Check every bitmap lies inside the data, so drawing never needs to,
+    // and that the glyphs are in codepoint order for the lookups
+    size_t bitmap_len = bufinfo.len - tables;
+    for (int i = 0; i < hdr->glyph_count; i++) {
+        const font_glyph_t *g = &self->glyphs[i];
+        size_t size = (hdr->bpp == 8 ? g->w : (g->w + 1) / 2) * g->h;
+        if (g->offset > bitmap_len || size > bitmap_len - g->offset) {
+            mp_raise_ValueError(MP_ERROR_TEXT("font data truncated"));
+        }
+        if (i > 0 && g->codepoint <= self->glyphs[i - 1].codepoint) {
+            mp_raise_ValueError(MP_ERROR_TEXT("font glyphs not sorted"));
+        }
+    }
+    if (hdr->fallback != FONT_NO_GLYPH && hdr->fallback >= hdr->glyph_count) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid fallback glyph"));
+    }
+
+    for (int i = 0; i < 95; i++) {
+        self->ascii[i] = FONT_NO_GLYPH;
+    }
+    for (int i = 0; i < hdr->glyph_count && self->glyphs[i].codepoint < 0x7F; i++) {
+        uint32_t cp = self->glyphs[i].codepoint;
+        if (cp >= 0x20) {
+            self->ascii[cp - 0x20] = i;
+        }
+    }
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// measure(text) -> (width, height), without rendering
+static mp_obj_t st7701_font_measure(mp_obj_t self_in, mp_obj_t text_in) {
+    st7701_font_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    size_t len;
+    const char *p = mp_obj_str_get_data(text_in, &len);
+    const char *end = p + len;
+
+    int width = 0;
+    int lines = 0;
+    while (p < end) {
+        int w = font_line_width(self, &p, end);
+        if (w > width) {
+            width = w;
+        }
+        lines++;
+    }
+    if (len > 0 && end[-1] == '\n') {
+        lines++;
+    }
+
+    mp_obj_t tuple[2] = {
+        mp_obj_new_int(width),
+        mp_obj_new_int(lines * self->header->line_height)
+    };
+    return mp_obj_new_tuple(2, tuple);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(st7701_font_measure_obj, st7701_font_measure);
+
+// line_height()
+static mp_obj_t st7701_font_line_height(mp_obj_t self_in) {
+    st7701_font_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int(self->header->line_height);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_font_line_height_obj, st7701_font_line_height);
+
+// ascent()
+static mp_obj_t st7701_font_ascent(mp_obj_t self_in) {
+    st7701_font_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int(self->header->ascent);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(st7701_font_ascent_obj, st7701_font_ascent);
+
+static const mp_rom_map_elem_t st7701_font_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_measure),     MP_ROM_PTR(&st7701_font_measure_obj) },
+    { MP_ROM_QSTR(MP_QSTR_line_height), MP_ROM_PTR(&st7701_font_line_height_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ascent),      MP_ROM_PTR(&st7701_font_ascent_obj) },
+};
+static MP_DEFINE_CONST_DICT(st7701_font_locals_dict, st7701_font_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    st7701_font_type,
+    MP_QSTR_Font,
+    MP_TYPE_FLAG_NONE,
+    make_new, st7701_font_make_new,
+    locals_dict, &st7701_font_locals_dict
+);
+
+// draw_text(font, text, x, y, colour, [bg], [clip]) -> x after the last glyph
+// font is a Font or a font asset. bg = -1 blends onto the framebuffer, clip = (x, y, w, h)
+static mp_obj_t st7701_draw_text(size_t n_args, const mp_obj_t *args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_draw_text);
+    st7701_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    st7701_surface_t surface;
+    st7701_get_surface(self, &surface);
+
+    size_t len;
+    const char *str = mp_obj_str_get_data(args[2], &len);
+    int x = mp_obj_get_int(args[3]);
+    int y = mp_obj_get_int(args[4]);
+    uint16_t colour = mp_obj_get_int(args[5]);
+    int32_t bg = n_args > 6 ? mp_obj_get_int(args[6]) : -1;
+
+    st7701_rect_t clip = { 0, 0, surface.width, surface.height };
+    if (n_args > 7 && args[7] != mp_const_none) {
+        mp_obj_t *rect;
+        mp_obj_get_array_fixed_n(args[7], 4, &rect);
+        clip.x0 = mp_obj_get_int(rect[0]);
+        clip.y0 = mp_obj_get_int(rect[1]);
+        clip.x1 = clip.x0 + mp_obj_get_int(rect[2]);
+        clip.y1 = clip.y0 + mp_obj_get_int(rect[3]);
+    }
+
+    return mp_obj_new_int(st7701_text_draw(&surface, &clip, args[1], str, len, x, y, colour, bg));
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_draw_text_obj, 6, 8, st7701_draw_text);
@@ -0,0 +1,348 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - tracing
+ *
+ * Native entry points and the panel ISR record timed events into a ring
+ * buffer per core, and trace_dump() writes them out as Chrome trace-event
+ * JSON, to open in ui.perfetto.dev or chrome://tracing. Recording only
+ * happens between trace_begin() and trace_end(); build with ST7701_TRACE=0
+ * to compile every trace point out.
+ *
+ * Timestamps are CPU cycle counts. Each core has its own counter, started
+ * at a different time, so a core's counts are moved onto a timeline shared
+ * by both with an offset taken against esp_timer (the systimer) the first
+ * time that core records. The cores line up to within a microsecond, and
+ * events on one core keep their exact spacing. Counts wrap every 17s at
+ * 240MHz, which is as long as a trace can usefully be.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/obj.h"
+#include "py/stream.h"
+#include "py/builtin.h"
+#include "py/mperrno.h"
+
+#include "esp_heap_caps.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+#include "st7701.h"
+
+#define TRACE_DEFAULT_EVENTS    2048    // per core, 12 bytes each
+#define TRACE_MAX_EVENTS        8192
+#define TRACE_OUT_SIZE          1024
+
+#if ST7701_TRACE
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+typedef struct _trace_event_t {
+    uint32_t start;         // on the shared timeline, in cycles
+    uint32_t cycles;        // duration of a span
+    uint16_t name;          // qstr
+    uint8_t kind;           // TRACE_*
+} trace_event_t;
+
+// Written only by its own core. A task and an ISR on the same core can
+// interleave, so a slot is claimed with an atomic increment.
+typedef struct _trace_ring_t {
+    trace_event_t *events;
+    uint32_t mask;          // size - 1, the size is a power of two
+    uint32_t head;          // events recorded since trace_begin()
+    uint32_t offset;        // added to this core's cycle counts for the shared timeline
+    volatile bool synced;   // offset taken since trace_begin()
+} trace_ring_t;
+
+typedef struct _trace_state_t {
+    trace_ring_t rings[2];
+    uint32_t size;          // events per ring
+    uint32_t base;          // shared timeline at trace_begin()
+    uint32_t per_us;        // cycles per microsecond
+} trace_state_t;
+
+static trace_state_t trace;
+
+volatile bool st7701_tracing;
+
+// The shared timeline: esp_timer microseconds in cycles, wrapping with them
+static inline uint32_t IRAM_ATTR trace_now(void) {
+    return (uint32_t)esp_timer_get_time() * trace.per_us;
+}
+
+// Offset from this core's cycle counter to the shared timeline
+static inline void IRAM_ATTR trace_sync(trace_ring_t *ring) {
+    ring->offset = trace_now() - esp_cpu_get_cycle_count();
+    ring->synced = true;
+}
+
+void IRAM_ATTR st7701_trace_record(uint16_t name, uint8_t kind, uint32_t start, uint32_t cycles) {
+    if (!st7701_tracing) {
+        return;
+    }
+    trace_ring_t *ring = &trace.rings[esp_cpu_get_core_id()];
+    if (!ring->synced) {
+        trace_sync(ring);
+    }
+    uint32_t i = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED) & ring->mask;
+    trace_event_t *ev = &ring->events[i];
+    ev->start = start + ring->offset;
+    ev->cycles = cycles;
+    ev->name = name;
+    ev->kind = kind;
+}
+
+static void trace_free(void) {
+    for (int c = 0; c < 2; c++) {
+        heap_caps_free(trace.rings[c].events);
+        trace.rings[c].events = NULL;
+    }
+    trace.size = 0;
+}
+
+// Stop recording and wait out any event being written
+static void trace_stop(void) {
+    if (st7701_tracing) {
+        st7701_tracing = false;
+        st7701_wait_frame(100);
+    }
+}
+
+// ============================================================================
+// JSON Output
+// ============================================================================
+
+typedef struct _trace_out_t {
+    mp_obj_t file;
+    char *buf;
+    size_t len;
+} trace_out_t;
+
+static void out_flush(trace_out_t *out) {
+    if (out->len == 0) {
+        return;
+    }
+    int errcode;
+    mp_uint_t n = mp_stream_rw(out->file, out->buf, out->len, &errcode, MP_STREAM_RW_WRITE);
+    if (errcode != 0) {
+        mp_raise_OSError(errcode);
+    }
+    if (n != out->len) {
+        mp_raise_OSError(MP_ENOSPC);
+    }
+    out->len = 0;
+}
+
+// Append one formatted record (always well under 256 bytes)
+static void out_printf(trace_out_t *out, const char *fmt, ...) {
+    if (out->len + 256 > TRACE_OUT_SIZE) {
+        out_flush(out);
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    out->len += vsnprintf(out->buf + out->len, TRACE_OUT_SIZE - out->len, fmt, ap);
+    va_end(ap);
+}
+
+// Cycles to microseconds with three decimals, as "%u.%03u"
+static void split_us(uint32_t cycles, uint32_t per_us, uint32_t *us, uint32_t *frac) {
+    *us = cycles / per_us;
+    *frac = (cycles % per_us) * 1000 / per_us;
+}
+
+static void write_event(trace_out_t *out, const trace_event_t *ev, int core, uint32_t per_us) {
+    static const char *const phase[] = { "X", "X", "i", "B", "E", "i" };
+    static const char *const cat[] = { "native", "scanout", "scanout", "python", "python", "python" };
+
+    // A span can start just before trace_begin()
+    int32_t rel = ev->start - trace.base;
+    uint32_t us, frac;
+    split_us(rel > 0 ? rel : 0, per_us, &us, &frac);
+    out_printf(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%u.%03u",
+               qstr_str(ev->name), cat[ev->kind], phase[ev->kind], core, (unsigned)us, (unsigned)frac);
+    if (ev->kind == TRACE_NATIVE || ev->kind == TRACE_SCANOUT) {
+        split_us(ev->cycles, per_us, &us, &frac);
+        out_printf(out, ",\"dur\":%u.%03u}", (unsigned)us, (unsigned)frac);
+    } else if (ev->kind == TRACE_FRAME || ev->kind == TRACE_PY_MARK) {
+        out_printf(out, ",\"s\":\"t\"}");
+    } else {
+        out_printf(out, "}");
+    }
+}
+
+// Write every event still in the rings, oldest first on each core.
+// Returns the number of events written.
+static uint32_t write_trace(trace_out_t *out) {
+    uint32_t per_us = trace.per_us;
+    uint32_t count = 0;
+
+    out_printf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+               "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"st7701\"}}");
+    for (int c = 0; c < 2; c++) {
+        const trace_ring_t *ring = &trace.rings[c];
+        out_printf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"core %d\"}}", c, c);
+
+        uint32_t n = ring->head < trace.size ? ring->head : trace.size;
+        for (uint32_t i = ring->head - n; i != ring->head; i++) {
+            write_event(out, &ring->events[i & ring->mask], c, per_us);
+        }
+        count += n;
+    }
+    out_printf(out, "\n]}\n");
+    out_flush(out);
+
+    return count;
+}
+
+#endif // ST7701_TRACE
+
+// ============================================================================
+// MicroPython Interface
+// ============================================================================
+
+static void check_trace(void) {
+#if !ST7701_TRACE
+    mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("tracing not built in (ST7701_TRACE=0)"));
+#endif
+}
+
+// trace_begin(events=2048)
+// Start recording, keeping the last `events` events on each core
+static mp_obj_t st7701_trace_begin(size_t n_args, const mp_obj_t *args) {
+    check_trace();
+#if ST7701_TRACE
+    mp_int_t events = n_args > 0 ? mp_obj_get_int(args[0]) : TRACE_DEFAULT_EVENTS;
+    if (events < 16 || events > TRACE_MAX_EVENTS) {
+        mp_raise_ValueError(MP_ERROR_TEXT("events out of range"));
+    }
+    uint32_t size = 16;
+    while (size < (uint32_t)events) {
+        size <<= 1;
+    }
+
+    trace_stop();
+    if (size != trace.size) {
+        trace_free();
+        // Internal RAM, as the ISR writes to it
+        for (int c = 0; c < 2; c++) {
+            trace.rings[c].events = heap_caps_malloc(size * sizeof(trace_event_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (trace.rings[c].events == NULL) {
+                trace_free();
+                mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Trace buffer allocation failed"));
+            }
+        }
+        trace.size = size;
+    }
+    for (int c = 0; c < 2; c++) {
+        trace.rings[c].mask = size - 1;
+        trace.rings[c].head = 0;
+        trace.rings[c].synced = false;
+    }
+    trace.per_us = esp_rom_get_cpu_ticks_per_us();
+    trace_sync(&trace.rings[esp_cpu_get_core_id()]);
+    trace.base = trace_now();
+    st7701_tracing = true;
+#endif
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_trace_begin_obj, 0, 1, st7701_trace_begin);
+
+// trace_end() -> (recorded, lost)
+// Stop recording. lost counts the oldest events overwritten when a ring
+// filled up.
+static mp_obj_t st7701_trace_end(void) {
+    check_trace();
+#if ST7701_TRACE
+    trace_stop();
+    uint32_t recorded = 0;
+    uint32_t lost = 0;
+    for (int c = 0; c < 2; c++) {
+        uint32_t head = trace.rings[c].head;
+        recorded += head;
+        lost += head > trace.size ? head - trace.size : 0;
+    }
+    mp_obj_t tuple[2] = {
+        mp_obj_new_int_from_uint(recorded),
+        mp_obj_new_int_from_uint(lost),
+    };
+    return mp_obj_new_tuple(2, tuple);
+#else
+    return mp_const_none;
+#endif
+}
+MP_DEFINE_CONST_FUN_OBJ_0(st7701_trace_end_obj, st7701_trace_end);
+
+// trace_mark(label, phase='i')
+// Record a Python event: 'B' starts a span, 'E' ends the last one started
+// on this core and 'i' is an instant
+static mp_obj_t st7701_trace_mark(size_t n_args, const mp_obj_t *args) {
+#if ST7701_TRACE
+    if (!st7701_tracing) {
+        return mp_const_none;
+    }
+    qstr label = mp_obj_str_get_qstr(args[0]);
+    uint8_t kind = TRACE_PY_MARK;
+    if (n_args > 1) {
+        const char *phase = mp_obj_str_get_str(args[1]);
+        if (phase[0] == 'B') {
+            kind = TRACE_PY_BEGIN;
+        } else if (phase[0] == 'E') {
+            kind = TRACE_PY_END;
+        } else if (phase[0] != 'i') {
+            mp_raise_ValueError(MP_ERROR_TEXT("phase must be 'B', 'E' or 'i'"));
+        }
+    }
+    st7701_trace_record(label, kind, esp_cpu_get_cycle_count(), 0);
+#endif
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(st7701_trace_mark_obj, 1, 2, st7701_trace_mark);
+
+// trace_dump(file) -> number of events written
+// file is a path or a stream opened for writing. Stops recording first.
+static mp_obj_t st7701_trace_dump(mp_obj_t file_in) {
+    check_trace();
+#if ST7701_TRACE
+    trace_stop();
+    if (trace.size == 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("nothing traced"));
+    }
+
+    // Open a path, otherwise write to the stream as given
+    mp_obj_t file = file_in;
+    bool opened = mp_obj_is_str(file);
+    if (opened) {
+        file = mp_call_function_2(MP_OBJ_FROM_PTR(&mp_builtin_open_obj), file, MP_OBJ_NEW_QSTR(MP_QSTR_wb));
+    }
+    mp_get_stream_raise(file, MP_STREAM_OP_WRITE);
+
+    // On the MicroPython heap, so it is collected if a write raises
+    trace_out_t out = { .file = file, .buf = m_new(char, TRACE_OUT_SIZE), .len = 0 };
+
+    nlr_buf_t nlr;
+    uint32_t count = 0;
+    if (nlr_push(&nlr) == 0) {
+        count = write_trace(&out);
+        nlr_pop();
+    } else {
+        if (opened) {
+            mp_stream_close(file);
+        }
+        nlr_jump(nlr.ret_val);
+    }
+
+    m_del(char, out.buf, TRACE_OUT_SIZE);
+    if (opened) {
+        mp_stream_close(file);
+    }
+    return mp_obj_new_int_from_uint(count);
+#else
+    return mp_const_none;
+#endif
+}
+MP_DEFINE_CONST_FUN_OBJ_1(st7701_trace_dump_obj, st7701_trace_dump);
@@ -0,0 +1,266 @@
+/*
+ * ST7701 RGB LCD Driver for MicroPython - screen transitions
+ *
+ * Animates from one full-screen RGB565 image to another: the new screen
+ * slides in over the old one, wipes across it, pushes it off, or fades in.
+ * Each step is drawn into the back buffer by a task on the other core and
+ * shown at the next frame, paced by the time elapsed rather than a frame
+ * count, so a slow step drops frames instead of stretching the transition.
+ *
+ * A step only writes what has changed in the buffer being drawn since that
+ * buffer was last drawn: the strip uncovered by a wipe, the moving part of
+ * a slide. A push moves everything, and a crossfade has 33 blend levels, so
+ * steps that would repeat the level are skipped.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/obj.h"
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "st7701.h"
+
+#define TRANSITION_STACK        4096
+#define TRANSITION_MAX_MS       10000
+#define FADE_LEVELS             32          // blend565() alpha range
+
+typedef struct _transition_t {
+    st7701_obj_t *display;
+    const uint16_t *from;
+    const uint16_t *to;
+    int kind;
+    int direction;
+    int width;
+    int height;
+    int length;                 // steps from start to end: pixels moved, or fade levels
+    uint32_t duration_us;
+    int drawn[2];               // step last drawn into each buffer, -1 if unknown
+
+    // Results
+    uint32_t steps;
+    uint32_t frames;
+    uint32_t elapsed_us;
+
+    SemaphoreHandle_t done;
+} transition_t;
+
+// ============================================================================
+// Drawing
+// ============================================================================
+
+// Copy n columns (or rows) from position src_pos in src to dst_pos in dst,
+// along the axis of the transition
+static void copy_band(const transition_t *t, uint16_t *dst, const uint16_t *src, int dst_pos, int src_pos, int n) {
+    if (n <= 0) {
+        return;
+    }
+    int w = t->width;
+    if (t->direction == TRANSITION_UP || t->direction == TRANSITION_DOWN) {
+        memcpy(dst + dst_pos * w, src + src_pos * w, n * w * sizeof(uint16_t));
+        return;
+    }
+    for (int y = 0; y < t->height; y++) {
+        memcpy(dst + y * w + dst_pos, src + y * w + src_pos, n * sizeof(uint16_t));
+    }
+}
+
+static void draw_crossfade(const transition_t *t, uint16_t *dst, int level) {
+    size_t n = (size_t)t->width * t->height;
+    if (level == 0 || level == FADE_LEVELS) {
+        memcpy(dst, level == 0 ? t->from : t->to, n * sizeof(uint16_t));
+        return;
+    }
+    const uint16_t *from = t->from;
+    const uint16_t *to = t->to;
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = blend565(to[i], from[i], level);
+    }
+}
+
+// Draw step d (0..length) into dst, which has step prev on it (-1 if unknown)
+static void draw_step(const transition_t *t, uint16_t *dst, int d, int prev) {
+    if (t->kind == TRANSITION_CROSSFADE) {
+        draw_crossfade(t, dst, d);
+        return;
+    }
+
+    // The new screen enters from the right (or bottom) when moving left (or
+    // up), otherwise from the left (or top)
+    int len = t->length;
+    bool forward = t->direction == TRANSITION_LEFT || t->direction == TRANSITION_UP;
+    int to_pos = forward ? len - d : 0;
+    int from_pos = forward ? 0 : d;
+
+    switch (t->kind) {
+        case TRANSITION_WIPE:
+            // Neither screen moves, only the edge between them
+            if (prev < 0) {
+                copy_band(t, dst, t->from, from_pos, from_pos, len - d);
+                copy_band(t, dst, t->to, to_pos, to_pos, d);
+            } else if (forward) {
+                copy_band(t, dst, t->to, len - d, len - d, d - prev);
+            } else {
+                copy_band(t, dst, t->to, prev, prev, d - prev);
+            }
+            break;
+
+        case TRANSITION_SLIDE:
+            // The old screen stays put and is only ever covered up further
+            if (prev < 0) {
+                copy_band(t, dst, t->from, from_pos, from_pos, len - d);
+            }
+            copy_band(t, dst, t->to, to_pos, forward ? 0 : len - d, d);
+            break;
+
+        case TRANSITION_PUSH:
+            copy_band(t, dst, t->from, from_pos, forward ? d : 0, len - d);
+            copy_band(t, dst, t->to, to_pos, forward ? 0 : len - d, d);
+            break;
+    }
+}
+
+// Draw step d into the back buffer unless it is already there
+static void render(transition_t *t, int d) {
+    st7701_obj_t *display = t->display;
+    int b = display->num_buffers == 2 ? display->back : 0;
+    if (t->drawn[b] != d) {
+        ST7701_TRACE_SCOPE(MP_QSTR_transition_step);
+        draw_step(t, display->framebuffer, d, t->drawn[b]);
+        t->drawn[b] = d;
+    }
+}
+
+// ============================================================================
+// Transition Task
+// ============================================================================
+
+static void transition_task(void *arg) {
+    transition_t *t = arg;
+    st7701_obj_t *display = t->display;
+
+    uint32_t first = st7701_frame_count();
+    int64_t start = esp_timer_get_time();
+    int d = 0;
+    do {
+        uint32_t elapsed = esp_timer_get_time() - start;
+        d = elapsed >= t->duration_us ? t->length : (int)((uint64_t)elapsed * t->length / t->duration_us);
+        render(t, d);
+        // Shows the step at the start of the next frame. With a single
+        // buffer it was drawn in place, and this just paces the steps.
+        st7701_flip(display);
+        t->steps++;
+    } while (d < t->length);
+    t->elapsed_us = esp_timer_get_time() - start;
+    t->frames = st7701_frame_count() - first;
+
+    // Bring the new back buffer up to date too, so both show the new screen
+    if (display->num_buffers == 2) {
+        render(t, t->length);
+    }
+
+    xSemaphoreGive(t->done);
+    vTaskDelete(NULL);
+}
+
+// ============================================================================
+// MicroPython Interface
+// ============================================================================
+
+static const uint16_t *get_screen(mp_obj_t buf_in, size_t size) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_READ);
+    if (bufinfo.len < size) {
+        mp_raise_ValueError(MP_ERROR_TEXT("buffer smaller than the screen"));
+    }
+    return bufinfo.buf;
+}
+
+// transition(from_buf, to_buf, kind, duration_ms, direction=TRANSITION_LEFT)
+//     -> (steps, dropped, fps)
+// Animate from one screen to another, both width() x height() RGB565, and
+// leave to_buf on screen. Blocks until it is finished, with the GIL
+// released. dropped counts the frames in which no new step was ready.
+static mp_obj_t st7701_transition(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    ST7701_TRACE_SCOPE(MP_QSTR_transition);
+    enum { ARG_self, ARG_from, ARG_to, ARG_kind, ARG_duration_ms, ARG_direction };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_self,         MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_from_buf,     MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_to_buf,       MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_kind,         MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_duration_ms,  MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_direction,    MP_ARG_INT, {.u_int = TRANSITION_LEFT} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    st7701_obj_t *display = MP_OBJ_TO_PTR(args[ARG_self].u_obj);
+    st7701_surface_t surface;
+    st7701_get_surface(display, &surface);
+
+    mp_int_t kind = args[ARG_kind].u_int;
+    mp_int_t direction = args[ARG_direction].u_int;
+    mp_int_t duration_ms = args[ARG_duration_ms].u_int;
+    if (kind < TRANSITION_SLIDE || kind > TRANSITION_PUSH) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid transition kind"));
+    }
+    if (direction < TRANSITION_LEFT || direction > TRANSITION_DOWN) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid transition direction"));
+    }
+    if (duration_ms < 0 || duration_ms > TRANSITION_MAX_MS) {
+        mp_raise_ValueError(MP_ERROR_TEXT("duration_ms out of range"));
+    }
+
+    size_t size = surface.width * surface.height * sizeof(uint16_t);
+    transition_t t = {
+        .display = display,
+        .from = get_screen(args[ARG_from].u_obj, size),
+        .to = get_screen(args[ARG_to].u_obj, size),
+        .kind = kind,
+        .direction = direction,
+        .width = surface.width,
+        .height = surface.height,
+        .duration_us = duration_ms * 1000,
+        .drawn = { -1, -1 },
+    };
+    if (kind == TRANSITION_CROSSFADE) {
+        t.length = FADE_LEVELS;
+    } else if (direction == TRANSITION_UP || direction == TRANSITION_DOWN) {
+        t.length = surface.height;
+    } else {
+        t.length = surface.width;
+    }
+    if (t.duration_us == 0) {
+        t.duration_us = 1;      // straight to the end
+    }
+
+    t.done = xSemaphoreCreateBinary();
+    if (t.done == NULL) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Failed to start transition"));
+    }
+
+    // MicroPython runs on core 1, so draw on core 0. The buffers stay
+    // referenced from args while this waits.
+    if (xTaskCreatePinnedToCore(transition_task, "st7701_tr", TRANSITION_STACK, &t, 5, NULL, 0) != pdPASS) {
+        vSemaphoreDelete(t.done);
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Failed to start transition"));
+    }
+    MP_THREAD_GIL_EXIT();
+    xSemaphoreTake(t.done, portMAX_DELAY);
+    MP_THREAD_GIL_ENTER();
+    vSemaphoreDelete(t.done);
+
+    uint32_t dropped = t.frames > t.steps ? t.frames - t.steps : 0;
+    mp_obj_t result[3] = {
+        mp_obj_new_int_from_uint(t.steps),
+        mp_obj_new_int_from_uint(dropped),
+        mp_obj_new_float(t.elapsed_us ? t.steps * 1e6f / t.elapsed_us : 0.0f),
+    };
+    return mp_obj_new_tuple(3, result);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(st7701_transition_obj, 5, st7701_transition);
@@ -0,0 +1,181 @@
+"""
+Convert images to RGB565 assets for the display, a whole tree at a time.
+
+    python assets.py images/ -o assets/
+    python assets.py splash.png icons/ -o assets/ --rotate 90 --dither
+    python assets.py screens/ -o out/ --size 480x854 --format rle
+
+Directories are searched for images recursively and the output mirrors the
+tree, each image written as a .raw file (<HH width, height, then RGB565
+little-endian, as bmp2rgb.py writes and AssetCache loads) or with
+--format rle as an .rle file (the capture() RLE format, which disp.py can
+show).
+
+Whole images are converted with numpy rather than a pixel at a time, on a
+worker per CPU core. A hash of each source file and the options used is
+kept in the output directory, so running it again only converts the images
+that changed; --force converts everything.
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import struct
+import sys
+import time
+from concurrent.futures import ProcessPoolExecutor
+
+import numpy as np
+from PIL import Image
+
+from stream import rle
+
+IMAGE_TYPES = {".bmp", ".png", ".jpg", ".jpeg", ".gif", ".tga", ".tif", ".tiff", ".webp"}
+CACHE_FILE = ".assets-cache.json"
+VERSION = 1             # change when the output for the same options changes
+
+# 4x4 ordered dither thresholds, 0..1
+BAYER4 = (np.array([[0, 8, 2, 10],
+                    [12, 4, 14, 6],
+                    [3, 11, 1, 9],
+                    [15, 7, 13, 5]]) + 0.5) / 16
+
+
+def to_rgb565(rgb, dither=False):
+    """RGB565 values (2-D uint16) of an RGB888 image (h x w x 3 uint8)."""
+    if not dither:
+        rgb = rgb.astype(np.uint16)
+        return ((rgb[..., 0] & 0xF8) << 8) | ((rgb[..., 1] & 0xFC) << 3) | (rgb[..., 2] >> 3)
+
+    # Round each channel up or down by where the pixel falls in the pattern
+    h, w = rgb.shape[:2]
+    threshold = np.tile(BAYER4, (h // 4 + 1, w // 4 + 1))[:h, :w]
+    levels = np.array([31, 63, 31])
+    q = np.floor(rgb * (levels / 255.0) + threshold[..., None])
+    q = np.minimum(q, levels).astype(np.uint16)
+    return (q[..., 0] << 11) | (q[..., 1] << 5) | q[..., 2]
+
+
+def encode(pixels, fmt):
+    """File contents for a 2-D uint16 image."""
+    h, w = pixels.shape
+    if fmt == "raw":
+        return struct.pack("<HH", w, h) + pixels.astype("<u2").tobytes()
+    # Runs don't cross rows, as capture() writes them
+    return b"S7RL" + struct.pack("<HH", w, h) + b"".join(rle(row) for row in pixels)
+
+
+def convert(src, dst, options):
+    """Convert one image. Runs in a worker process."""
+    img = Image.open(src).convert("RGB")
+    if options["size"]:
+        img = img.resize(options["size"], Image.LANCZOS)
+    rgb = np.asarray(img)
+    if options["rotate"]:
+        rgb = np.rot90(rgb, k=-(options["rotate"] // 90))    # clockwise
+    pixels = to_rgb565(rgb, options["dither"])
+
+    data = encode(pixels, options["format"])
+    os.makedirs(os.path.dirname(dst) or ".", exist_ok=True)
+    tmp = dst + ".tmp"
+    with open(tmp, "wb") as f:
+        f.write(data)
+    os.replace(tmp, dst)
+    return pixels.shape[1], pixels.shape[0], len(data)
+
+
+def find_images(paths):
+    """(source, path relative to its input) for every image under paths."""
+    for path in paths:
+        if os.path.isdir(path):
+            for root, dirs, files in os.walk(path):
+                dirs.sort()
+                for name in sorted(files):
+                    if os.path.splitext(name)[1].lower() in IMAGE_TYPES:
+                        src = os.path.join(root, name)
+                        yield src, os.path.relpath(src, path)
+        else:
+            yield path, os.path.basename(path)
+
+
+def file_hash(path, options):
+    h = hashlib.sha256(json.dumps([VERSION, options], sort_keys=True).encode())
+    with open(path, "rb") as f:
+        for block in iter(lambda: f.read(1 << 20), b""):
+            h.update(block)
+    return h.hexdigest()
+
+
+def parse_size(text):
+    try:
+        w, h = (int(v) for v in text.lower().split("x"))
+    except ValueError:
+        raise argparse.ArgumentTypeError("size must be WxH, e.g. 480x854")
+    return w, h
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert images to RGB565 assets for an st7701 display")
+    parser.add_argument("inputs", nargs="+", help="image files or directories")
+    parser.add_argument("-o", "--output", required=True, help="output directory")
+    parser.add_argument("--rotate", type=int, default=0, choices=[0, 90, 180, 270],
+                        help="rotate clockwise before converting")
+    parser.add_argument("--size", type=parse_size, help="resize to WxH first (before rotating)")
+    parser.add_argument("--dither", action="store_true", help="ordered dither down to RGB565")
+    parser.add_argument("--format", default="raw", choices=["raw", "rle"])
+    parser.add_argument("--jobs", type=int, default=os.cpu_count(), help="worker processes (default: one per CPU)")
+    parser.add_argument("--force", action="store_true", help="convert every image, even if unchanged")
+    args = parser.parse_args()
+
+    options = {"rotate": args.rotate, "size": args.size, "dither": args.dither, "format": args.format}
+    cache_path = os.path.join(args.output, CACHE_FILE)
+    try:
+        with open(cache_path) as f:
+            cache = json.load(f)
+    except (OSError, ValueError):
+        cache = {}
+
+    # Work out what needs converting
+    work = []
+    skipped = 0
+    for src, rel in find_images(args.inputs):
+        name = os.path.splitext(rel)[0] + "." + args.format
+        dst = os.path.join(args.output, name)
+        digest = file_hash(src, options)
+        if not args.force and cache.get(name) == digest and os.path.exists(dst):
+            skipped += 1
+            continue
+        work.append((src, name, dst, digest))
+
+    start = time.time()
+    failed = 0
+    total = 0
+    if work:
+        with ProcessPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+            futures = [(src, name, dst, digest, pool.submit(convert, src, dst, options))
+                       for src, name, dst, digest in work]
+            for src, name, dst, digest, future in futures:
+                try:
+                    w, h, size = future.result()
+                except Exception as e:
+                    print(f"{src}: {e}", file=sys.stderr)
+                    cache.pop(name, None)
+                    failed += 1
+                    continue
+                cache[name] = digest
+                total += size
+                print(f"{dst} ({w}x{h}, {size} bytes)")
+
+        os.makedirs(args.output, exist_ok=True)
+        with open(cache_path, "w") as f:
+            json.dump(cache, f, indent=1, sort_keys=True)
+
+    print(f"{len(work) - failed} converted in {time.time() - start:.2f}s ({total} bytes), "
+          f"{skipped} unchanged, {failed} failed")
+    if failed:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,26 +1,26 @@
 from PIL import Image
+import numpy as np
 import struct
 import sys
 
+# Converts one image. To convert many (or rotate, resize or dither them),
+# use assets.py.
+
 def convert_rgb565(input_file, output_file):
     img = Image.open(input_file).convert("RGB")  # Explicitly use RGB mode
     width, height = img.size
 
+    # Standard RGB565 packing, the whole image at once
+    rgb = np.asarray(img).astype(np.uint16)
+    rgb565 = ((rgb[..., 0] & 0xF8) << 8) | ((rgb[..., 1] & 0xFC) << 3) | (rgb[..., 2] >> 3)
+
     with open(output_file, "wb") as f:
         # Optional: write header (little-endian width/height)
         f.write(struct.pack("<HH", width, height))
 
-        for y in range(height):
-            for x in range(width):
-                r, g, b = img.getpixel((x, y))  # Directly get R, G, B
-
-                # Standard RGB565 packing
-                rgb565 = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
-
-                # Little-endian 16-bit write
-                f.write(struct.pack("<H", rgb565))
+        # Little-endian 16-bit pixels
+        f.write(rgb565.astype("<u2").tobytes())
 
     print(f"Saved {output_file} ({width}x{height})")
 
 convert_rgb565(sys.argv[1], sys.argv[2])
-
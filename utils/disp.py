@@ -2,44 +2,112 @@ import sys
 import struct
 import tkinter as tk
 
+import numpy as np
 
-def rgb565_to_rgb888(pixel):
-    r = (pixel >> 11) & 0x1F
-    g = (pixel >> 5) & 0x3F
-    b = pixel & 0x1F
+
+def rgb565_to_rgb888(pixels):
+    """RGB888 bytes of an array of RGB565 values, all at once."""
+    p = pixels.astype(np.uint16)
+    r = (p >> 11) & 0x1F
+    g = (p >> 5) & 0x3F
+    b = p & 0x1F
 
     r = (r << 3) | (r >> 2)
     g = (g << 2) | (g >> 4)
     b = (b << 3) | (b >> 2)
 
-    return r, g, b
+    return np.stack((r, g, b), axis=-1).astype(np.uint8).tobytes()
+
+
+def decode_rle(data, width, height):
+    """Decode the RLE rows of an S7RL capture into little-endian RGB565 bytes."""
+    out = bytearray()
+    p = 0
+    while p < len(data) and len(out) < width * height * 2:
+        c = data[p]
+        p += 1
+        if c & 0x80:
+            out += data[p:p + 2] * ((c & 0x7F) + 1)
+            p += 2
+        else:
+            n = (c + 1) * 2
+            out += data[p:p + n]
+            p += n
+    return out
+
+
+def decode_qoi(data):
+    """Decode a QOI image, returning (rgb bytes, width, height)."""
+    width, height, channels = struct.unpack_from(">IIB", data, 4)
+    index = [(0, 0, 0, 0)] * 64
+    r, g, b, a = 0, 0, 0, 255
+    pixels = bytearray()
+    p = 14
+    n = 0
+    total = width * height
+    while n < total:
+        op = data[p]
+        p += 1
+        count = 1
+        if op == 0xFE:
+            r, g, b = data[p:p + 3]
+            p += 3
+        elif op == 0xFF:
+            r, g, b, a = data[p:p + 4]
+            p += 4
+        elif op >> 6 == 0:
+            r, g, b, a = index[op]
+        elif op >> 6 == 1:
+            r = (r + ((op >> 4) & 3) - 2) & 0xFF
+            g = (g + ((op >> 2) & 3) - 2) & 0xFF
+            b = (b + (op & 3) - 2) & 0xFF
+        elif op >> 6 == 2:
+            vg = (op & 0x3F) - 32
+            op2 = data[p]
+            p += 1
+            r = (r + vg + (op2 >> 4) - 8) & 0xFF
+            g = (g + vg) & 0xFF
+            b = (b + vg + (op2 & 0x0F) - 8) & 0xFF
+        else:
+            count = (op & 0x3F) + 1     # a run is written in one go
+        index[(r * 3 + g * 5 + b * 7 + a * 11) % 64] = (r, g, b, a)
+        pixels += bytes((r, g, b)) * count
+        n += count
+    return pixels[:total * 3], width, height
 
 
 def load_rgb565_as_ppm(filename):
+    """Load a .raw file, or a capture from ST7701.capture() (raw, RLE or QOI)."""
     with open(filename, "rb") as f:
         data = f.read()
 
-    width, height = struct.unpack_from("<HH", data, 0)
-    print(width, height)
-    pixel_data = data[4:]
+    if data[:4] == b"qoif":
+        pixels, width, height = decode_qoi(data)
+        print(width, height, "(QOI)")
+        return f"P6 {width} {height} 255\n".encode() + pixels, width, height
+
+    if data[:4] == b"S7RL":
+        width, height = struct.unpack_from("<HH", data, 4)
+        print(width, height, "(RLE)")
+        pixel_data = decode_rle(data[8:], width, height)
+    else:
+        width, height = struct.unpack_from("<HH", data, 0)
+        print(width, height)
+        pixel_data = data[4:]
 
     expected = width * height * 2
     if len(pixel_data) < expected:
         raise ValueError("File too small")
 
     header = f"P6 {width} {height} 255\n".encode()
-    pixels = bytearray()
-
-    for i in range(0, expected, 2):
-        pixel = struct.unpack_from("<H", pixel_data, i)[0]
-        pixels.extend(rgb565_to_rgb888(pixel))
+    pixels = rgb565_to_rgb888(np.frombuffer(pixel_data, "<u2", width * height))
 
     return header + pixels, width, height
 
 
 def main():
     if len(sys.argv) != 2:
-        print("Usage: python view_rgb565.py <file.rgb565>")
+        print("Usage: python disp.py <file.raw | capture.rle | capture.qoi>")
         sys.exit(1)
 
     filename = sys.argv[1]
@@ -0,0 +1,121 @@
+"""
+Convert a TrueType/OpenType font into the st7701 Font format.
+
+    python font2bin.py DejaVuSans.ttf 24 sans24.bin
+    python font2bin.py DejaVuSans.ttf 32 sans32.bin --bpp 8 --chars " 0123456789.-%"
+
+Glyphs are rendered anti-aliased with Pillow and stored as 4-bit (default)
+or 8-bit alpha, with metrics and kerning pairs. Load it on the device with
+st7701.Font("sans24.bin").
+
+Kerning is measured through Pillow's text layout - fonts that only carry
+GPOS kerning need Pillow built with libraqm to produce any pairs.
+"""
+
+from PIL import Image, ImageDraw, ImageFont
+import argparse
+import struct
+
+MAGIC = b"S7FT"
+VERSION = 1
+NO_GLYPH = 0xFFFF
+
+HEADER = "<4sBBHHHhhHH"     # 20 bytes
+GLYPH = "<IIBBbbB3x"        # 16 bytes
+KERN = "<HHhxx"             # 8 bytes
+
+DEFAULT_CHARS = "".join(chr(c) for c in range(0x20, 0x7F)) + "°±µ·×€£"
+
+
+def clamp(v, lo, hi):
+    return max(lo, min(hi, v))
+
+
+def render_glyph(font, ch, bpp):
+    """Return (w, h, x_off, y_off, advance, bitmap bytes) for one character."""
+    advance = round(font.getlength(ch))
+    x0, y0, x1, y1 = font.getbbox(ch, anchor="ls")
+    w, h = x1 - x0, y1 - y0
+    if w <= 0 or h <= 0:
+        return 0, 0, 0, 0, advance, b""
+
+    img = Image.new("L", (w, h), 0)
+    ImageDraw.Draw(img).text((-x0, -y0), ch, font=font, fill=255, anchor="ls")
+    alpha = img.tobytes()
+
+    if bpp == 8:
+        bitmap = alpha
+    else:
+        # 4-bit, rows padded to a whole byte, high nibble first
+        bitmap = bytearray()
+        for y in range(h):
+            row = alpha[y * w:(y + 1) * w]
+            for x in range(0, w, 2):
+                hi = (row[x] + 8) // 17
+                lo = (row[x + 1] + 8) // 17 if x + 1 < w else 0
+                bitmap.append((hi << 4) | lo)
+        bitmap = bytes(bitmap)
+
+    return w, h, clamp(x0, -128, 127), clamp(y0, -128, 127), advance, bitmap
+
+
+def kerning_pairs(font, chars, glyph_index, advances):
+    """Kerning as the difference between a pair's length and its parts."""
+    pairs = []
+    for a in chars:
+        for b in chars:
+            adjust = round(font.getlength(a + b) - advances[a] - advances[b])
+            if adjust:
+                pairs.append((glyph_index[a], glyph_index[b], adjust))
+    pairs.sort()
+    return pairs
+
+
+def convert_font(font_file, size, output_file, bpp, chars, kerning):
+    font = ImageFont.truetype(font_file, size)
+    ascent, descent = font.getmetrics()
+
+    chars = sorted(set(chars), key=ord)
+    glyph_index = {ch: i for i, ch in enumerate(chars)}
+
+    glyphs = []
+    bitmaps = bytearray()
+    advances = {}
+    for ch in chars:
+        w, h, x_off, y_off, advance, bitmap = render_glyph(font, ch, bpp)
+        glyphs.append(struct.pack(GLYPH, ord(ch), len(bitmaps), w, h, x_off, y_off, clamp(advance, 0, 255)))
+        bitmaps += bitmap
+        advances[ch] = font.getlength(ch)
+
+    pairs = kerning_pairs(font, chars, glyph_index, advances) if kerning else []
+    fallback = glyph_index.get("?", NO_GLYPH)
+
+    with open(output_file, "wb") as f:
+        f.write(struct.pack(HEADER, MAGIC, VERSION, bpp, len(glyphs), len(pairs),
+                            ascent + descent, ascent, descent, fallback, 0))
+        for g in glyphs:
+            f.write(g)
+        for left, right, adjust in pairs:
+            f.write(struct.pack(KERN, left, right, adjust))
+        f.write(bitmaps)
+
+    size_total = 20 + 16 * len(glyphs) + 8 * len(pairs) + len(bitmaps)
+    print(f"Saved {output_file} ({len(glyphs)} glyphs, {len(pairs)} kerning pairs, "
+          f"line height {ascent + descent}, {size_total} bytes)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a font for st7701.Font")
+    parser.add_argument("font", help="TrueType/OpenType font file")
+    parser.add_argument("size", type=int, help="pixel size")
+    parser.add_argument("output", help="output .bin file")
+    parser.add_argument("--bpp", type=int, choices=(4, 8), default=4, help="alpha bits per pixel")
+    parser.add_argument("--chars", default=DEFAULT_CHARS, help="characters to include")
+    parser.add_argument("--no-kerning", action="store_true", help="omit kerning pairs")
+    args = parser.parse_args()
+
+    convert_font(args.font, args.size, args.output, args.bpp, args.chars, not args.no_kerning)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,177 @@
+"""
+Stream frames to a display running st7701.StreamReceiver.
+
+    python stream.py frame1.raw frame2.raw ... --port /dev/ttyACM0
+    python stream.py frame*.raw --rotate 90 --stdout | ./stream_host out.raw
+
+Frames are .raw files as written by bmp2rgb.py (or image files, which are
+converted with Pillow). Only bands of rows that changed since the previous
+frame are sent, each as a single rectangle coded raw, RLE, as an RLE XOR
+delta or as a fill - whichever is smallest. With --rotate the frames are in
+the rotated orientation (e.g. 854x480 for 90) and the device rotates them
+as they are written.
+
+See modules/st7701/st7701_stream.h for the protocol.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+import numpy as np
+
+SYNC = 0xA5
+
+FRAME_BEGIN = 0x01
+FRAME_END = 0x02
+RECT_RAW = 0x10
+RECT_RLE = 0x11
+RECT_XOR = 0x12
+FILL = 0x13
+
+PANEL_W, PANEL_H = 480, 854
+ROTATIONS = {0: 0, 90: 1, 180: 2, 270: 3}
+
+
+def packet(ptype, payload=b""):
+    return struct.pack("<BBI", SYNC, ptype, len(payload)) + payload
+
+
+def rle(values):
+    """RLE code a 1-D uint16 array: runs of 2+ and blocks of literals."""
+    n = len(values)
+    if n == 0:
+        return b""
+    starts = np.flatnonzero(np.diff(values)) + 1
+    starts = np.concatenate(([0], starts))
+    lengths = np.diff(np.concatenate((starts, [n])))
+    raw = values.astype("<u2").tobytes()
+
+    out = bytearray()
+    lit_start = lit_len = 0
+
+    def flush_literals():
+        nonlocal lit_len
+        pos = lit_start
+        while lit_len:
+            k = min(lit_len, 128)
+            out.append(k - 1)
+            out.extend(raw[pos * 2:(pos + k) * 2])
+            pos += k
+            lit_len -= k
+
+    for start, length in zip(starts.tolist(), lengths.tolist()):
+        if length == 1:
+            if lit_len == 0:
+                lit_start = start
+            lit_len += 1
+            continue
+        flush_literals()
+        value = raw[start * 2:start * 2 + 2]
+        while length:
+            k = min(length, 128)
+            out.append(0x80 | (k - 1))
+            out.extend(value)
+            length -= k
+    flush_literals()
+    return bytes(out)
+
+
+def encode_rect(x, y, new, old):
+    """Smallest packet for one rectangle. old is None if the device content is unknown."""
+    h, w = new.shape
+    head = struct.pack("<HHHH", x, y, w, h)
+    flat = new.ravel()
+
+    if (flat == flat[0]).all():
+        return packet(FILL, head + struct.pack("<H", int(flat[0])))
+
+    options = [packet(RECT_RAW, head + flat.astype("<u2").tobytes()),
+               packet(RECT_RLE, head + rle(flat))]
+    if old is not None:
+        options.append(packet(RECT_XOR, head + rle(flat ^ old.ravel())))
+    return min(options, key=len)
+
+
+def encode_frame(frame, prev, rotation, band):
+    """Encode one frame (2-D uint16 array) as a delta against prev."""
+    out = [packet(FRAME_BEGIN, bytes([rotation]))]
+    h = frame.shape[0]
+    for y in range(0, h, band):
+        new = frame[y:y + band]
+        if prev is None:
+            x0, x1 = 0, new.shape[1]
+        else:
+            old = prev[y:y + band]
+            cols = np.flatnonzero((new != old).any(axis=0))
+            if len(cols) == 0:
+                continue
+            x0, x1 = int(cols[0]), int(cols[-1]) + 1
+        out.append(encode_rect(x0, y, new[:, x0:x1],
+                               None if prev is None else prev[y:y + band, x0:x1]))
+    out.append(packet(FRAME_END))
+    return b"".join(out)
+
+
+def load_frame(filename):
+    if filename.endswith(".raw"):
+        with open(filename, "rb") as f:
+            data = f.read()
+        width, height = struct.unpack_from("<HH", data, 0)
+        pixels = np.frombuffer(data, "<u2", width * height, 4)
+        return pixels.reshape(height, width).astype(np.uint16)
+
+    from PIL import Image
+    rgb = np.asarray(Image.open(filename).convert("RGB")).astype(np.uint16)
+    return ((rgb[..., 0] & 0xF8) << 8) | ((rgb[..., 1] & 0xFC) << 3) | (rgb[..., 2] >> 3)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stream frames to an st7701 display")
+    parser.add_argument("frames", nargs="+", help=".raw or image files, one per frame")
+    parser.add_argument("--rotate", type=int, default=0, choices=sorted(ROTATIONS))
+    parser.add_argument("--band", type=int, default=16, help="rows per delta band (default 16)")
+    parser.add_argument("--fps", type=float, default=0, help="limit the frame rate (default: as fast as possible)")
+    parser.add_argument("--loop", type=int, default=1, help="times to play the frames (0 = forever)")
+    out = parser.add_mutually_exclusive_group(required=True)
+    out.add_argument("--port", help="serial port, e.g. /dev/ttyACM0 (USB-CDC) or /dev/ttyUSB0")
+    out.add_argument("--stdout", action="store_true", help="write the stream to stdout")
+    parser.add_argument("--baud", type=int, default=921600)
+    args = parser.parse_args()
+
+    rotation = ROTATIONS[args.rotate]
+    width, height = (PANEL_H, PANEL_W) if rotation & 1 else (PANEL_W, PANEL_H)
+    frames = [load_frame(f) for f in args.frames]
+    for name, frame in zip(args.frames, frames):
+        if frame.shape != (height, width):
+            sys.exit(f"{name} is {frame.shape[1]}x{frame.shape[0]}, expected {width}x{height}")
+
+    if args.stdout:
+        sink = sys.stdout.buffer
+    else:
+        import serial
+        sink = serial.Serial(args.port, args.baud)
+
+    prev = None
+    sent = count = 0
+    start = time.time()
+    loop = 0
+    while args.loop == 0 or loop < args.loop:
+        for frame in frames:
+            data = encode_frame(frame, prev, rotation, args.band)
+            sink.write(data)
+            prev = frame
+            sent += len(data)
+            count += 1
+            if args.fps:
+                time.sleep(max(0, start + count / args.fps - time.time()))
+        loop += 1
+    sink.flush()
+
+    full = count * width * height * 2
+    print(f"{count} frames, {sent} bytes ({100 * sent / full:.1f}% of raw)", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,73 @@
+/*
+ * Run the st7701 stream decoder on a PC, standing in for the serial link:
+ *
+ *     cc -O2 -I modules/st7701 -o stream_host utils/stream_host.c modules/st7701/st7701_stream.c
+ *     python utils/stream.py frame*.raw --stdout | ./stream_host out.raw
+ *
+ * The stream is read from stdin in small chunks so packets are split at
+ * arbitrary points, as they are on a UART. The last frame shown is written
+ * to out.raw in the same format as bmp2rgb.py, so it can be viewed with
+ * disp.py.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "st7701_stream.h"
+
+#define WIDTH   480
+#define HEIGHT  854
+
+static uint16_t buffers[2][WIDTH * HEIGHT];
+static int back = 1;
+
+static uint16_t *back_buffer(void *ctx) {
+    return buffers[back];
+}
+
+static const uint16_t *front_buffer(void *ctx) {
+    return buffers[back ^ 1];
+}
+
+static void flip(void *ctx) {
+    back ^= 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s out.raw < stream\n", argv[0]);
+        return 1;
+    }
+
+    static st7701_stream_t stream;
+    st7701_stream_target_t target = {
+        .back_buffer = back_buffer,
+        .front_buffer = front_buffer,
+        .flip = flip,
+        .width = WIDTH,
+        .height = HEIGHT,
+    };
+    st7701_stream_init(&stream, &target);
+
+    uint8_t buf[1000];
+    size_t n;
+    while ((n = fread(buf, 1, 1 + rand() % sizeof(buf), stdin)) > 0) {
+        st7701_stream_feed(&stream, buf, n);
+    }
+
+    FILE *f = fopen(argv[1], "wb");
+    if (f == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    uint16_t header[2] = { WIDTH, HEIGHT };     // little-endian hosts only
+    fwrite(header, 2, 2, f);
+    fwrite(front_buffer(NULL), 2, WIDTH * HEIGHT, f);
+    fclose(f);
+
+    fprintf(stderr, "%u frames, %u rects, %u bytes, %u errors\n",
+            (unsigned)stream.stats.frames, (unsigned)stream.stats.rects,
+            (unsigned)stream.stats.bytes, (unsigned)stream.stats.errors);
+    return stream.stats.errors ? 2 : 0;
+}